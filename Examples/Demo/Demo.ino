@@ -1,86 +1,82 @@
-#include <max7219.h>
+#include <SevSeg_MAX7219.h>
 
-MAX7219 max7219;
+#define DIN 12
+#define CLK 11
+#define CS  10
+
+SevSeg_MAX7219 sevSeg(DIN, CLK, CS);
 
 void setup() {
   Serial.begin(9600);
-  max7219.Begin();
+  sevSeg.begin(8);
 }
 
 void loop() {
-  String temp;
-  char temp2[8];
-  int y;
-
   //DisplayText Demo
-  max7219.DisplayText("95.67F", 1); //Right justified
+  sevSeg.displayText("95.67F", true); //Right justified
   delay(3000);
-  max7219.Clear();
-  max7219.DisplayText("95.67F", 0); //Left justified
+  sevSeg.clear();
+  sevSeg.displayText("95.67F", false); //Left justified
   delay(3000);
-  max7219.Clear();
+  sevSeg.clear();
 
   //Counter with decimals
   //slow counter
-  for (float x = 0; x < 1; x = x + 0.1) {
-    temp = String(x);
-    temp.toCharArray(temp2, temp.length());
-    max7219.DisplayText(temp2, 1); //0=left justify 1=right justify
+  for (int x = 0; x < 10; x++) {
+    sevSeg.displayFixed(x, 1); //0.0 to 0.9, right justified
     Serial.println(x);
     delay(500);
   }
   //fast counter
-  for (float x = 0; x < 500; x++) {
-    temp = String(x);
-    temp.toCharArray(temp2, temp.length());
-    max7219.DisplayText(temp2, 1); //0=left justify 1=right justify
+  for (int x = 0; x < 500; x++) {
+    sevSeg.displayFixed(x * 10L, 1);
     Serial.println(x);
   }
   delay(500);
 
   //Display Char Demo
-  max7219.Clear();
-  max7219.DisplayChar(7, 'H', 0); //Position 7 is on the left of the display
+  sevSeg.clear();
+  sevSeg.displayChar(7, 'H', 0); //Position 7 is on the left of the display
   delay(500);
-  max7219.DisplayChar(6, 'E', 0);
+  sevSeg.displayChar(6, 'E', 0);
   delay(500);
-  max7219.DisplayChar(5, 'L', 0);
+  sevSeg.displayChar(5, 'L', 0);
   delay(500);
-  max7219.DisplayChar(4, 'L', 0);
+  sevSeg.displayChar(4, 'L', 0);
   delay(500);
-  max7219.DisplayChar(3, 'O', 0);
+  sevSeg.displayChar(3, 'O', 0);
   delay(500);
-  max7219.DisplayChar(2, '1', 0);
+  sevSeg.displayChar(2, '1', 0);
   delay(500);
-  max7219.DisplayChar(1, '2', 0);
+  sevSeg.displayChar(1, '2', 0);
   delay(500);
-  max7219.DisplayChar(0, '3', 0);
+  sevSeg.displayChar(0, '3', 0);
   delay(500);
-  max7219.Clear();
+  sevSeg.clear();
   //Count front the right
   for (int x = 0; x < 8; x++) {
-    max7219.DisplayChar(x, 48 + x, 0); //48 is ASCII value for 0
+    sevSeg.displayChar(x, 48 + x, 0); //48 is ASCII value for 0
     delay(500);
   }
-  max7219.Clear();
+  sevSeg.clear();
   delay(500);
   //Count from the left
   for (int x = 7; x >= 0; x--) {
-    max7219.DisplayChar(x, 48 + (7 - x), 0); //48 is ASCII value for 0
+    sevSeg.displayChar(x, 48 + (7 - x), 0); //48 is ASCII value for 0
     delay(500);
   }
-  max7219.Clear();
+  sevSeg.clear();
   //Count from the right
   for (int x = 0; x < 8; x++) {
-    max7219.DisplayChar(x, 48 + x, 0); //48 is ASCII value for 0
+    sevSeg.displayChar(x, 48 + x, 0); //48 is ASCII value for 0
     delay(500);
-    max7219.Clear();
+    sevSeg.clear();
   }
   delay(500);
   //Count front the left
   for (int x = 7; x >= 0; x--) {
-    max7219.DisplayChar(x, 48 + (7 - x), 0); //48 is ASCII value for 0
+    sevSeg.displayChar(x, 48 + (7 - x), 0); //48 is ASCII value for 0
     delay(500);
-    max7219.Clear();
+    sevSeg.clear();
   }
 }
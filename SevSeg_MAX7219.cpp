@@ -39,7 +39,8 @@
 *  - The host communicates with the MAX7219 using three signals: CLK, CS, DIN.
 *  - Pins can be configured in the constructor
 *  - The MAX7219 is a SPI interface
-*  - This library uses the bitbang method for communication with the MAX7219
+*  - This library uses the bitbang method for communication with the MAX7219 by
+*    default, or the hardware SPI peripheral if only the CS pin is given
 *
 * Usage
 *
@@ -56,7 +57,6 @@
 *  This method displays a text string (Text) either right justified (Justify=1) or left justified (Justify=0)
 */
 
-#include <avr/pgmspace.h> 
 #include "SevSeg_MAX7219.h"
 
 //MAX7219
@@ -71,28 +71,213 @@ const byte MAX7219_REG_DISPLAY_TEST  = 0x0f;
 #define INTENSITY_MAX     0x0f
 
 
-SevSeg_MAX7219::SevSeg_MAX7219(byte _dinPin, byte _clkPin, byte _csPin) :
-  dinPin(_dinPin), clkPin(_clkPin), csPin(_csPin),
-  digits(4), pos(0), autoscrolling(false)
+// Fonts: segments in register order: dp a b c d e f g
+// alternative capital J: 0B00111100
+const uint8_t SevSeg_MAX7219_Font[] PROGMEM = {
+  0B00000000, 0B10110000, 0B00100010, 0B00110111, 0,           // space!"#$
+  0,          0,          0B00100000, 0B01001110, 0B01111000,  // %&'()
+  0,          0,          0,          0B00000001, 0B10000000,  // *+,-.
+  0,                                                           // /
+  0x7e, 0x30, 0x6d, 0x79, 0x33,  // 0-4
+  0x5b, 0x5f, 0x70, 0x7f, 0x7b,  // 5-9
+  0,          0,          0,          0B00001001, 0,           // :;<=>
+  0B11100101, 0B01111101,                                      // ?@
+  0B01110111, 0B01111111, 0B01001110, 0B00111101, 0B01001111,  // A-E
+  0B01000111, 0B01011110, 0B00110111, 0B00110000, 0B00111000,  // F-J
+  0B01010111, 0B00001110, 0B01010100, 0B01110110, 0B01111110,  // K-O
+  0B01100111, 0B01110011, 0B00000101, 0B01011011, 0B00001111,  // P-T
+  0B00111110, 0,          0,          0,          0B00111011,  // U-Y
+  0B01101101,                                                  // Z
+  0B01001110, 0B00000010, 0B01111000, 0,          0B00001000,  // [\]^_
+  0B00100000,                                                  // '
+  0B01111101, 0B00011111, 0B00001101, 0B00111101, 0B01101111,  // a-e
+  0B01000111, 0B01111011, 0B00010111, 0B00000100, 0B00011000,  // f-j
+  0B01010111, 0B00000110, 0B01010100, 0B00010101, 0B00011101,  // k-o
+  0B01100111, 0B01110011, 0B00000101, 0B01011011, 0B00001111,  // p-t
+  0B00011100, 0,          0,          0,          0B00111011,  // u-y
+  0B01101101,                                                  // z
+  0B01001110, 0B00000110, 0B01111000                           // {|}
+};
+
+// Same as SevSeg_MAX7219_Font plus approximations of / % * V W X ^ ~ and the
+// Latin-1 degree sign '\xb0'.
+const uint8_t SevSeg_MAX7219_FontExtended[] PROGMEM = {
+  0B00000000, 0B10110000, 0B00100010, 0B00110111, 0,           // space!"#$
+  0B10100101, 0,          0B00100000, 0B01001110, 0B01111000,  // %&'()
+  0B01100011, 0,          0,          0B00000001, 0B10000000,  // *+,-.
+  0B00100101,                                                  // /
+  0x7e, 0x30, 0x6d, 0x79, 0x33,  // 0-4
+  0x5b, 0x5f, 0x70, 0x7f, 0x7b,  // 5-9
+  0,          0,          0,          0B00001001, 0,           // :;<=>
+  0B11100101, 0B01111101,                                      // ?@
+  0B01110111, 0B01111111, 0B01001110, 0B00111101, 0B01001111,  // A-E
+  0B01000111, 0B01011110, 0B00110111, 0B00110000, 0B00111000,  // F-J
+  0B01010111, 0B00001110, 0B01010100, 0B01110110, 0B01111110,  // K-O
+  0B01100111, 0B01110011, 0B00000101, 0B01011011, 0B00001111,  // P-T
+  0B00111110, 0B00111110, 0B00101010, 0B00110111, 0B00111011,  // U-Y
+  0B01101101,                                                  // Z
+  0B01001110, 0B00000010, 0B01111000, 0B01100010, 0B00001000,  // [\]^_
+  0B00100000,                                                  // '
+  0B01111101, 0B00011111, 0B00001101, 0B00111101, 0B01101111,  // a-e
+  0B01000111, 0B01111011, 0B00010111, 0B00000100, 0B00011000,  // f-j
+  0B01010111, 0B00000110, 0B01010100, 0B00010101, 0B00011101,  // k-o
+  0B01100111, 0B01110011, 0B00000101, 0B01011011, 0B00001111,  // p-t
+  0B00011100, 0B00011100, 0B00101010, 0B00110111, 0B00111011,  // u-y
+  0B01101101,                                                  // z
+  0B01001110, 0B00000110, 0B01111000, 0B01000000, 0,           // {|}~ DEL
+  0,          0,          0,          0,          0,           // 0x80-0xaf
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,          0,          0,
+  0,          0,          0,
+  0B01100011                                                   // degree
+};
+
+
+// Segments of the chip's Code B font: 0-9 - E H L P blank
+static const uint8_t codeBSegments[16] PROGMEM = {
+  0x7e, 0x30, 0x6d, 0x79, 0x33, 0x5b, 0x5f, 0x70,
+  0x7f, 0x7b, 0x01, 0x4f, 0x37, 0x0e, 0x67, 0x00
+};
+
+// Code B value for a segment pattern without dp, 0xff if there is none.
+static byte codeB(byte segments)
 {
-  pinMode(dinPin, OUTPUT);
-  pinMode(csPin, OUTPUT);
-  pinMode(clkPin, OUTPUT);
+  for (byte i = 0; i < 16; i++) {
+    if (pgm_read_byte(codeBSegments + i) == segments) return i;
+  }
+  return 0xff;
+}
+
+// Register value of a digit switching between raw segments and Code B.
+// Patterns Code B does not have become blank.
+static byte recode(byte value, bool toCodeB)
+{
+  if (!toCodeB)
+    return pgm_read_byte(codeBSegments + (value & 0x0f)) | (value & 0x80);
+  byte b = codeB(value & 0x7f);
+  return (b == 0xff) ? 0x0f : b | (value & 0x80);
+}
+
+static SevSeg_MAX7219_SPIBus hardwareSPIBus;
+
+
+SevSeg_MAX7219::SevSeg_MAX7219(byte _dinPin, byte _clkPin, byte _csPin, byte _devices) :
+  softBus(new SevSeg_MAX7219_SoftBus(_dinPin, _clkPin)), bus(softBus), csPin(_csPin)
+{
+  init(_devices);
+}
+
+SevSeg_MAX7219::SevSeg_MAX7219(byte _csPin, byte _devices) :
+  softBus(NULL), bus(&hardwareSPIBus), csPin(_csPin)
+{
+  init(_devices);
+}
+
+SevSeg_MAX7219::SevSeg_MAX7219(SevSeg_MAX7219_Bus & _bus, byte _csPin, byte _devices) :
+  softBus(NULL), bus(&_bus), csPin(_csPin)
+{
+  init(_devices);
+}
+
+SevSeg_MAX7219::~SevSeg_MAX7219()
+{
+  // bus is NULL if the bus was destroyed first
+  if (bus != NULL) {
+    for (SevSeg_MAX7219 ** p = &bus->displays; *p != NULL; p = &(*p)->nextOnBus) {
+      if (*p == this) {
+        *p = nextOnBus;
+        break;
+      }
+    }
+  }
+  if (front != buf) free(front);
+  free(buf);
+  delete softBus;
+  free(marquee);
 }
 
-void SevSeg_MAX7219::begin(byte digits)
+void SevSeg_MAX7219::init(byte _devices)
 {
+  digits = 4;
+  pos = 0;
+  autoscrolling = false;
+  deferred = 0;
+  nextOnBus = NULL;
+  diffing = false;
+  suppressed = 0;
+  setFont(SevSeg_MAX7219_Font, ' ', '}');
+  setFallback(SEVSEG_FALLBACK_BLANK);
+  memset(control, 0, sizeof(control));
+  unsent = 0xff;
+  lost = 0;
+  fineLevel = INTENSITY_MAX << 4;
+  marquee = NULL;
+  marqueeSize = 0;
+  marqueeLength = 0;
+  blinkMask = 0;
+  blinkOff = false;
+  fadeDuration = 0;
+  dithering = false;
+  ditherError = 0;
+  decodeMask = 0;
+  autoDecoding = false;
+  refreshPeriod = 0;
+
+  // One allocation holds buf, sent and dirty. Without memory the display
+  // simply has no digits.
+  buf = (char *) malloc(_devices * (8 + 8 + 1));
+  devices = buf ? _devices : 0;
+  sent = buf + 8 * devices;
+  dirty = (byte *) sent + 8 * devices;
+  memset(buf, 0, 8 * devices);
+  memset(dirty, 0, devices);
+  front = buf;
+}
+
+void SevSeg_MAX7219::begin(byte ndigits)
+{
+  // Displays sharing the bus set it up only once. They are linked here
+  // rather than in the constructor, which may run before the bus's.
+  if (!bus->started) {
+    bus->begin();
+    bus->started = true;
+  }
+  SevSeg_MAX7219 * d = bus->displays;
+  while (d != NULL && d != this)
+    d = d->nextOnBus;
+  if (d == NULL) {
+    nextOnBus = bus->displays;
+    bus->displays = this;
+  }
+  pinMode(csPin, OUTPUT);
   digitalWrite(csPin, HIGH);
 
-  if (digits < 4) digits = 4;
-  writeSPI(MAX7219_REG_SCAN_LIMIT, digits);
+  if (ndigits < 1) ndigits = 1;
+  if (ndigits > 8) ndigits = 8;
+  digits = ndigits;
+  memset(dirty, 0, devices);
+  // The chip may have been reset or not: write every register once.
+  unsent = 0xff;
+  lost = 0;
+  scanLimit(digits);
 
   // Turn BCD decoding off for all digits.
+  decodeMask = 0;
   writeSPI(MAX7219_REG_DECODE, 0x00);
 
+  // The digit registers are undefined at power-up: make sure clear()
+  // transmits all of them even in diffing mode.
+  memset(sent, 0xff, 8 * devices);
+  if (front != buf) memset(front, 0xff, 8 * devices);
   clear();
+  swap();
   noTestMode();
-
   brightness(INTENSITY_MAX);
 
   // Turn on display last.
@@ -100,13 +285,20 @@ void SevSeg_MAX7219::begin(byte digits)
 }
 
 void SevSeg_MAX7219::clear(void) {
-  for (int i = 0; i < 8; i++) {
-    buf[i] = 0x00;
-    writeSPI(i + 1, 0x00);
-  }
+  clearRange(0, digitCount());
   pos = 0;
 }
 
+// Multiplex only the first ndigits digits. Fewer digits get a larger share
+// of the scan cycle, i.e. are brighter and refreshed more often. Note the
+// datasheet's warning about segment current for scan limits below 3.
+void SevSeg_MAX7219::scanLimit(byte ndigits)
+{
+  if (ndigits < 1) ndigits = 1;
+  if (ndigits > digits) ndigits = digits;
+  writeSPI(MAX7219_REG_SCAN_LIMIT, ndigits - 1);
+}
+
 void SevSeg_MAX7219::display(void)
 {
   // normal operation
@@ -142,9 +334,374 @@ void SevSeg_MAX7219::noTestMode(void)
 void SevSeg_MAX7219::brightness(byte brightness)
 {
   brightness &= 0x0f;
+  fineLevel = brightness << 4;
+  fadeDuration = 0;
   writeSPI(MAX7219_REG_INTENSITY, brightness);
 }
 
+void SevSeg_MAX7219::fineBrightness(byte level)
+{
+  fineLevel = level;
+  fadeDuration = 0;
+  writeSPI(MAX7219_REG_INTENSITY, level >> 4);
+}
+
+void SevSeg_MAX7219::dither(void)
+{
+  dithering = true;
+}
+
+void SevSeg_MAX7219::noDither(void)
+{
+  dithering = false;
+  writeSPI(MAX7219_REG_INTENSITY, fineLevel >> 4);
+}
+
+void SevSeg_MAX7219::beginUpdate(void)
+{
+  deferred++;
+}
+
+void SevSeg_MAX7219::commit(void)
+{
+  if (deferred > 0) deferred--;
+  flush();
+}
+
+// Batch the digit writes of one call. Unlike commit(), endWrite() never
+// transmits with double buffering, so writers may run in an interrupt
+// handler while swap() or tick() is sending.
+void SevSeg_MAX7219::beginWrite(void)
+{
+  deferred++;
+}
+
+void SevSeg_MAX7219::endWrite(void)
+{
+  if (deferred > 0) deferred--;
+  if (front == buf) flush();
+}
+
+// Keep a second buffer for the transmitted digits. All changes, including
+// scrolling text, are only shown by the next swap().
+void SevSeg_MAX7219::doubleBuffer(void)
+{
+  if (front != buf) return;
+  char * b = (char *) malloc(8 * devices);
+  if (b == NULL) return;
+  memcpy(b, buf, 8 * devices);
+  front = b;
+}
+
+void SevSeg_MAX7219::noDoubleBuffer(void)
+{
+  if (front == buf) return;
+  swap();
+  free(front);
+  front = buf;
+}
+
+// Publish the contents written since the last swap. Interrupts are only
+// disabled while copying, not while transmitting.
+void SevSeg_MAX7219::swap(void)
+{
+  if (front == buf) return;
+#if defined(__AVR__)
+  uint8_t oldSREG = SREG;
+  cli();
+#else
+  noInterrupts();
+#endif
+  for (byte i = 0; i < digitCount(); i++) {
+    if (front[i] != buf[i]) {
+      front[i] = buf[i];
+      dirty[i / digits] |= 1 << (i % digits);
+    }
+  }
+#if defined(__AVR__)
+  SREG = oldSREG;
+#else
+  interrupts();
+#endif
+  flush();
+}
+
+void SevSeg_MAX7219::diffUpdates(void)
+{
+  diffing = true;
+}
+
+void SevSeg_MAX7219::noDiffUpdates(void)
+{
+  diffing = false;
+}
+
+unsigned long SevSeg_MAX7219::suppressedWrites(void)
+{
+  return suppressed;
+}
+
+void SevSeg_MAX7219::decodeDigits(byte mask)
+{
+  byte changed = mask ^ decodeMask;
+  if (changed == 0) return;
+
+  // Re-encode the buffers for the rows switching mode. The old register
+  // contents mean something else now, so they have to be sent again.
+  beginUpdate();
+  decodeMask = mask;
+  writeSPI(MAX7219_REG_DECODE, mask);
+  for (byte i = 0; i < digitCount(); i++) {
+    if (changed & (1 << (i % digits))) {
+      buf[i] = recode(buf[i], decoded(i));
+      if (front != buf) front[i] = recode(front[i], decoded(i));
+      sent[i] = ~output(i);
+      dirty[i / digits] |= 1 << (i % digits);
+    }
+  }
+  commit();
+}
+
+void SevSeg_MAX7219::autoDecode(void)
+{
+  autoDecoding = true;
+}
+
+void SevSeg_MAX7219::noAutoDecode(void)
+{
+  autoDecoding = false;
+}
+
+void SevSeg_MAX7219::setFont(const uint8_t * table, char first, char last)
+{
+  font = table;
+  fontFirst = first;
+  fontLast = last;
+}
+
+void SevSeg_MAX7219::setFallback(SevSeg_MAX7219_Fallback policy, byte glyph)
+{
+  fallbackGlyph = (policy == SEVSEG_FALLBACK_GLYPH) ? glyph : 0x00;
+  skipUnknown = (policy == SEVSEG_FALLBACK_SKIP);
+}
+
+void SevSeg_MAX7219::displayNumber(int32_t value, bool leadingZeros)
+{
+  displayFixed(value, 0, leadingZeros);
+}
+
+// Shows value / 10^decimals, e.g. displayFixed(-1234, 2) shows "-12.34".
+void SevSeg_MAX7219::displayFixed(int32_t value, uint8_t decimals, bool leadingZeros)
+{
+  uint32_t magnitude = (value < 0) ? -(uint32_t) value : value;
+  displayDigits(0, digitCount(), magnitude, 10, value < 0, decimals, leadingZeros);
+}
+
+void SevSeg_MAX7219::displayHex(uint32_t value, bool leadingZeros)
+{
+  displayDigits(0, digitCount(), value, 16, false, 0, leadingZeros);
+}
+
+// Fill the digits first..first+count-1 from the right. Numbers which do not
+// fit show dashes.
+void SevSeg_MAX7219::displayDigits(byte first, byte count, uint32_t value, byte base, bool negative, uint8_t decimals, bool leadingZeros)
+{
+  static const char digitChars[] PROGMEM = "0123456789AbCdEF";
+  byte last = first + count - 1;
+  byte n = 0;         // digits written, from the right
+  bool fits = false;
+
+  beginWrite();
+  if (autoDecoding && base == 10) {
+    // Decoding is set per row for all chips: leave rows which also hold
+    // digits outside the range, e.g. of another viewport, alone.
+    byte rows = 0xff;
+    for (byte i = 0; i < digitCount(); i++) {
+      if (i < first || i >= first + count) rows &= ~(1 << (i % digits));
+    }
+    decodeDigits(decodeMask | rows);
+  }
+  while (n < count) {
+    char c = pgm_read_byte(digitChars + value % base);
+    value /= base;
+    setDigit(last - n, glyph(last - n, c, decimals != 0 && n == decimals));
+    n++;
+    // at least one digit before the decimal point
+    if (value == 0 && n > decimals) {
+      fits = true;
+      break;
+    }
+  }
+  if (leadingZeros) {
+    for (; n < count - (negative ? 1 : 0); n++)
+      setDigit(last - n, glyph(last - n, '0', false));
+  }
+  if (negative) {
+    if (n < count) {
+      setDigit(last - n, glyph(last - n, '-', false));
+      n++;
+    } else {
+      fits = false;
+    }
+  }
+  if (!fits) {
+    for (n = 0; n < count; n++)
+      setDigit(last - n, glyph(last - n, '-', false));
+  }
+  for (; n < count; n++)
+    setDigit(last - n, blank(last - n));
+  endWrite();
+}
+
+// Get the next character to display from a string and return the position
+// after it, or NULL at the end. Dots are merged into the preceding character.
+// A dot without one, e.g. at the start, is shown as a blank digit with dp.
+const char * SevSeg_MAX7219::nextChar(const char * p, char & c, bool & dp)
+{
+  do {
+    c = *p++;
+    if (c == '\0') return NULL;
+  } while (c != '.' && skipped(c));
+
+  dp = (c == '.');
+  if (dp) c = ' ';
+  while (*p == '.') {
+    dp = true;
+    p++;
+  }
+  return p;
+}
+
+// The text is converted to segments once and stored in a ring followed by
+// one display width of blanks. Each step just shows the next window of the
+// ring, so the text can be of any length.
+void SevSeg_MAX7219::scrollText(const char * text, unsigned int interval)
+{
+  const char * p;
+  char c;
+  bool dp;
+  unsigned int n = 0;
+
+  for (p = text; (p = nextChar(p, c, dp)) != NULL; )
+    n++;
+
+  unsigned int length = n + digitCount();
+  if (length > marqueeSize) {
+    byte * ring = (byte *) realloc(marquee, length);
+    if (ring == NULL) return;
+    marquee = ring;
+    marqueeSize = length;
+  }
+  n = 0;
+  for (p = text; (p = nextChar(p, c, dp)) != NULL; )
+    marquee[n++] = lookup(c, dp);
+  memset(marquee + n, 0x00, length - n);
+
+  marqueeLength = length;
+  marqueeStep = 0;
+  marqueeInterval = interval;
+  marqueeTime = millis();
+  renderMarquee();
+}
+
+void SevSeg_MAX7219::noScrollText(void)
+{
+  marqueeLength = 0;
+}
+
+void SevSeg_MAX7219::blink(byte mask, unsigned int interval)
+{
+  blinkInterval = interval;
+  blinkTime = millis();
+  // digits which stop blinking have to be restored
+  noBlink();
+  blinkMask = mask;
+}
+
+void SevSeg_MAX7219::noBlink(void)
+{
+  byte mask = blinkOff ? blinkMask : 0;
+  // clear the flags first: output() must not blank the restored digits
+  blinkMask = 0;
+  blinkOff = false;
+  if (mask) {
+    for (byte i = 0; i < devices; i++)
+      dirty[i] |= mask;
+    flush();
+  }
+}
+
+void SevSeg_MAX7219::fadeBrightness(byte brightness, unsigned int duration)
+{
+  fadeFineBrightness((brightness & 0x0f) << 4, duration);
+}
+
+void SevSeg_MAX7219::fadeFineBrightness(byte level, unsigned int duration)
+{
+  fadeFrom = fineLevel;
+  fadeTo = level;
+  fadeDuration = duration ? duration : 1;
+  fadeStart = millis();
+}
+
+// Rewrite the chip registers from the library's copies, one register per
+// step, so that the whole chip state is restored within period ms. Guards
+// against registers corrupted by interference.
+void SevSeg_MAX7219::refresh(unsigned int period)
+{
+  refreshPeriod = period;
+  refreshTime = millis();
+  refreshNext = 0;
+}
+
+void SevSeg_MAX7219::noRefresh(void)
+{
+  refreshPeriod = 0;
+}
+
+void SevSeg_MAX7219::tick(unsigned long now)
+{
+  beginUpdate();
+  if (refreshPeriod != 0 && now - refreshTime >= refreshPeriod / (digits + 5)) {
+    refreshTime = now;
+    refreshRegister();
+  }
+  if (marqueeLength != 0 && now - marqueeTime >= marqueeInterval) {
+    marqueeTime = now;
+    marqueeStep++;
+    renderMarquee();
+  }
+  if (blinkMask != 0 && now - blinkTime >= blinkInterval) {
+    blinkTime = now;
+    blinkOff = !blinkOff;
+    for (byte i = 0; i < devices; i++)
+      dirty[i] |= blinkMask;
+  }
+  commit();
+
+  if (fadeDuration != 0) {
+    unsigned long t = now - fadeStart;
+    if (t < fadeDuration) {
+      fineLevel = fadeFrom + ((int) fadeTo - fadeFrom) * (long) t / fadeDuration;
+    } else {
+      fineLevel = fadeTo;
+      fadeDuration = 0;
+    }
+  }
+
+  // Error diffusion: over 16 ticks a fraction of n/16 shows the next
+  // level n times.
+  byte level = fineLevel >> 4;
+  if (dithering && level < INTENSITY_MAX) {
+    ditherError += fineLevel & 0x0f;
+    if (ditherError >= 16) {
+      ditherError -= 16;
+      level++;
+    }
+  }
+  writeSPI(MAX7219_REG_INTENSITY, level);
+}
+
 void SevSeg_MAX7219::home(void)
 {
   pos = 0;
@@ -156,112 +713,345 @@ void SevSeg_MAX7219::setCursor(byte x, byte y)
 }
 
 size_t SevSeg_MAX7219::write(uint8_t ch)
+{
+  writeRange(0, digitCount(), pos, autoscrolling, ch);
+  return 1;
+}
+
+// Strings and formatted numbers from print() arrive here: all characters
+// go to the buffer first and are transmitted in one flush.
+size_t SevSeg_MAX7219::write(const uint8_t * buffer, size_t size)
+{
+  beginWrite();
+  for (size_t i = 0; i < size; i++)
+    writeRange(0, digitCount(), pos, autoscrolling, buffer[i]);
+  endWrite();
+  return size;
+}
+
+void SevSeg_MAX7219::displayChar(char digit, char value, bool dp)
+{
+  if ((byte) digit >= digitCount() || skipped(value)) return;
+  byte code = glyph(digit, value, dp);
+  buf[int(digit)] = code;
+  writeDigit(digit);
+}
+
+void SevSeg_MAX7219::displayText(const char *text, bool rightjustify)
+{
+  displayTextRange(0, digitCount(), text, rightjustify);
+}
+
+void SevSeg_MAX7219::clearRange(byte first, byte count)
+{
+  beginWrite();
+  for (byte i = first; i < first + count; i++) {
+    buf[i] = blank(i);
+    writeDigit(i);
+  }
+  endWrite();
+}
+
+// Print a character at cursor, counted from first, and advance the cursor.
+void SevSeg_MAX7219::writeRange(byte first, byte count, byte & cursor, bool scrolling, uint8_t ch)
 {
   // special handling of dots/fullstops.
   if (ch == '.') {
     // add dp to previous symbol
-    byte p = (pos > 0) ? pos - 1 : 0;
-    buf[p] |= 0x80;
-    writeSPI(p + 1, buf[p]);
-    return 1;
+    byte p = (cursor > 0) ? cursor - 1 : 0;
+    if (p >= count) return;
+    buf[first + p] |= 0x80;
+    writeDigit(first + p);
+    return;
   }
-  if (autoscrolling && pos == digits) {
-    for (byte i = 0; i < digits - 1; i++) {
-      buf[i] = buf[i + 1];
-      writeSPI(i + 1, buf[i]);
-    }
-    displayChar(digits - 1, ch, false);
+  if (skipped(ch) || count == 0) return;
+  if (scrolling && cursor == count) {
+    beginWrite();
+    // only digits whose neighbour differs need to be sent
+    for (byte i = first; i < first + count - 1; i++)
+      setDigit(i, encode(i, segments(i + 1)));
+    displayChar(first + count - 1, ch, false);
+    endWrite();
   } else {
-    displayChar(pos++, ch, false);
+    if (cursor < count) displayChar(first + cursor, ch, false);
+    cursor++;
   }
-  return 1;
 }
 
-void SevSeg_MAX7219::displayChar(char digit, char value, bool dp)
+void SevSeg_MAX7219::displayTextRange(byte first, byte count, const char * text, bool rightjustify)
 {
-  byte code = lookup(value, dp);
-  buf[int(digit)] = code;
-  writeSPI(digit + 1, code);
+  const char * p;
+  char c;
+  bool dp;
+  byte n = 0;
+
+  // count the digits needed, up to the width of the range
+  for (p = text; n < count && (p = nextChar(p, c, dp)) != NULL; )
+    n++;
+
+  beginWrite();
+  byte d = rightjustify ? first + count - n : first;
+  for (p = text; n > 0; n--, d++) {
+    p = nextChar(p, c, dp);
+    buf[d] = glyph(d, c, dp);
+    writeDigit(d);
+  }
+  endWrite();
 }
 
-void SevSeg_MAX7219::displayText(const char *text, bool rightjustify)
+// The text enters on the right and leaves on the left, then starts over.
+void SevSeg_MAX7219::renderMarquee(void)
 {
-  bool decimal[16];
-  char trimStr[16] = "";
-  int x, y = 0;
-  int s;
+  if (marqueeStep >= marqueeLength) marqueeStep = 0;
+  // step 0 shows the blanks at the end of the ring
+  unsigned int i = marqueeStep + marqueeLength - digitCount();
 
-  s = strlen(text);
-  if (s > 16) s = 16;
-  for (x = 0; x < s; x++) {
-    if (text[x] == '.') {
-      decimal[y - 1] = true;
-    } else {
-      trimStr[y] = text[x];
-      decimal[y] = false;
-      y++;
-    }
+  beginWrite();
+  for (byte d = 0; d < digitCount(); d++, i++) {
+    if (i >= marqueeLength) i -= marqueeLength;
+    setDigit(d, encode(d, marquee[i]));
   }
-  if (y > digits) y = digits;
+  endWrite();
+}
 
-  for (x = 0; x < y; x++) {
-    if (!rightjustify)
-      displayChar(x, trimStr[x], decimal[x]);
-    else
-      displayChar(digits - y + x, trimStr[x], decimal[x]);
+// Send the next digit row or control register, even if unchanged.
+void SevSeg_MAX7219::refreshRegister(void)
+{
+  static const byte registers[] PROGMEM = {
+    MAX7219_REG_DECODE, MAX7219_REG_SCAN_LIMIT, MAX7219_REG_INTENSITY,
+    MAX7219_REG_DISPLAY_TEST, MAX7219_REG_SHUTDOWN
+  };
+
+  if (refreshNext >= digits + sizeof(registers)) refreshNext = 0;
+  if (refreshNext < digits) {
+    for (byte chip = 0; chip < devices; chip++) {
+      byte i = chip * digits + refreshNext;
+      sent[i] = ~output(i);
+      dirty[chip] |= 1 << refreshNext;
+    }
+  } else {
+    byte opcode = pgm_read_byte(registers + refreshNext - digits);
+    byte r = opcode - MAX7219_REG_DECODE;
+    unsent |= 1 << r;
+    writeSPI(opcode, control[r]);
   }
+  refreshNext++;
 }
 
+// Write the same control register on all chips. Writes which would not
+// change the register are skipped, writes the bus dropped are repeated by
+// the next flush().
 void SevSeg_MAX7219::writeSPI(byte opcode, byte data)
 {
-  // FIXME: optionally use hardware SPI
-  digitalWrite(csPin, LOW);
-  shiftOut(dinPin, clkPin, MSBFIRST, opcode);
-  shiftOut(dinPin, clkPin, MSBFIRST, data);
-  digitalWrite(csPin, HIGH);
+  byte r = opcode - MAX7219_REG_DECODE;
+  byte bit = 1 << r;
+  if (!((unsent | lost) & bit) && control[r] == data) return;
+  control[r] = data;
+  unsent &= ~bit;
+  lost &= ~bit;
+
+  bus->select(csPin);
+  for (byte i = 0; i < devices; i++)
+    bus->transfer16((opcode << 8) | data);
+  if (!bus->deselect(csPin)) lost |= bit;
 }
 
-byte SevSeg_MAX7219::lookup(char c, bool dp)
+// Digit 0 is the leftmost digit of the first chip in the chain, i.e. the one
+// connected to the MCU. With double buffering swap() marks the digits.
+void SevSeg_MAX7219::writeDigit(byte digit)
 {
-  byte pat;
-
-  // hex encoded values:  MSB is segment A, LSB segment P
-  const static byte pattern[94] PROGMEM = {
-    0B00000000, 0B01100001, 0B01000100, 0B01101110, 0,           // space!"#$
-    0,          0,          0B01000000, 0B10011100, 0B11110000,  // %&'()
-    0,          0,          0,          0B00000010, 0B00000001,  // *+,-.
-    0,                                                           // /
-    0xfc, 0x60, 0xda, 0xf2, 0x66,  // 0-4
-    0xb6, 0xbe, 0xe0, 0xfe, 0xf6,  // 5-9
-    0,          0,          0,          0B00010010, 0,           // :;<=>
-    0B11001011, 0B11111010,                                      // ?@
-    0B11101110, 0B11111110, 0B10011100, 0B01111010, 0B10011110,  // A-E
-    0B10001110, 0B10111100, 0B01101110, 0B01100000, 0B01110000,  // F-J
-    0B10101110, 0B00011100, 0B10101000, 0B11101100, 0B11111100,  // K-O
-    0B11001110, 0B11100110, 0B00001010, 0B10110110, 0B00011110,  // P-T
-    0B01111100, 0,          0,          0,          0B01110110,  // U-Y
-    0B11011010,                                                  // Z
-    0B10011100, 0B00000100, 0B11110000, 0,          0B00010000,  // [\]^_
-    0B01000000,                                                  // '
-    0B11111010, 0B00111110, 0B00011010, 0B01111010, 0B11011110,  // a-e
-    0B10001110, 0B11110110, 0B00101110, 0B00001000, 0B00110000,  // f-j
-    0B10101110, 0B00001100, 0B10101000, 0B00101010, 0B00111010,  // k-o
-    0B11001110, 0B11100110, 0B00001010, 0B10110110, 0B00011110,  // p-t
-    0B00111000, 0,          0,          0,          0B01110110,  // u-y
-    0B11011010,                                                  // z
-    0B10011100, 0B00001100, 0B11110000                           // {|}
-  };
-/*
-    case '°': // not ASCII
-      pattern = 0B11000110;
-      break;
-*/
-  // 0B01111000  // alternative capital J
-  if (c >= ' ' && c <= '}') {
-    // pat = pattern[(int) c];
-    pat = pgm_read_byte_near(pattern + (int) c - ' ');
-    pat = (pat >> 1) | (pat << 7);
+  if (front != buf) return;
+  dirty[digit / digits] |= 1 << (digit % digits);
+  flush();
+}
+
+// Like writeDigit(), but only marks the digit if its segments change.
+void SevSeg_MAX7219::setDigit(byte digit, byte code)
+{
+  if ((byte) buf[digit] == code) return;
+  buf[digit] = code;
+  writeDigit(digit);
+}
+
+// Send the marked digit rows unless deferred. The display stays deferred
+// while sending, so a writer interrupting the transfer cannot start its own.
+void SevSeg_MAX7219::flush(void)
+{
+  if (deferring()) return;
+  deferred++;
+  resendLost();
+  for (byte row = 0; row < digits; row++)
+    sendRow(row);
+  deferred--;
+}
+
+// Write the control registers whose last write the bus dropped.
+void SevSeg_MAX7219::resendLost(void)
+{
+  for (byte r = 0; r < sizeof(control); r++) {
+    if (lost & (1 << r)) writeSPI(MAX7219_REG_DECODE + r, control[r]);
+  }
+}
+
+// Update one digit row of all chips in a single transaction. Chips with
+// nothing to change receive a NOOP.
+void SevSeg_MAX7219::sendRow(byte row)
+{
+  byte mask = 1 << row;
+  byte pending = 0;
+
+  for (byte chip = 0; chip < devices; chip++) {
+    if (!(dirty[chip] & mask)) continue;
+    byte i = chip * digits + row;
+    if (diffing && sent[i] == output(i)) {
+      dirty[chip] &= ~mask;
+      suppressed++;
+    } else {
+      pending++;
+    }
+  }
+  if (pending == 0) return;
+
+  // The word for the last chip in the chain has to be shifted out first.
+  bus->select(csPin);
+  for (byte chip = devices; chip-- > 0; ) {
+    byte i = chip * digits + row;
+    if (dirty[chip] & mask) {
+      dirty[chip] &= ~mask;
+      sent[i] = output(i);
+      bus->transfer16(((row + 1) << 8) | (byte) sent[i]);
+    } else {
+      bus->transfer16(MAX7219_REG_NOOP << 8);
+    }
+  }
+  if (!bus->deselect(csPin)) {
+    // Which chips had a word in the frame is gone: send the row to all of
+    // them again, past the diffing.
+    for (byte chip = 0; chip < devices; chip++) {
+      sent[chip * digits + row] = ~output(chip * digits + row);
+      dirty[chip] |= mask;
+    }
   }
+}
+
+byte SevSeg_MAX7219::lookup(char c, bool dp)
+{
+  byte pat = fallbackGlyph;
+  byte i = (byte) c - fontFirst;
+
+  if (i <= fontLast - fontFirst)
+    pat = pgm_read_byte(font + i);
   if (dp) pat |= 0x80;
   return pat;
 }
+
+// Register value showing c on a digit. In Code B mode digits go to the chip
+// as they are, without font lookup.
+byte SevSeg_MAX7219::glyph(byte digit, char c, bool dp)
+{
+  if (decoded(digit) && c >= '0' && c <= '9')
+    return (c - '0') | (dp ? 0x80 : 0x00);
+  return encode(digit, lookup(c, dp));
+}
+
+// Register value showing a segment pattern on a digit. Patterns Code B does
+// not have switch the row to raw segments with autoDecode(), or are blank.
+byte SevSeg_MAX7219::encode(byte digit, byte segments)
+{
+  if (!decoded(digit)) return segments;
+  byte b = codeB(segments & 0x7f);
+  if (b != 0xff) return b | (segments & 0x80);
+  if (!autoDecoding) return 0x0f | (segments & 0x80);
+  decodeDigits(decodeMask & ~(1 << (digit % digits)));
+  return segments;
+}
+
+// Segment pattern shown on a digit.
+byte SevSeg_MAX7219::segments(byte digit)
+{
+  if (!decoded(digit)) return buf[digit];
+  return pgm_read_byte(codeBSegments + (buf[digit] & 0x0f)) | (buf[digit] & 0x80);
+}
+
+
+
+SevSeg_MAX7219_Viewport::SevSeg_MAX7219_Viewport(SevSeg_MAX7219 & _display, byte _first, byte _count) :
+  sevSeg(_display), first(_first), count(_count), pos(0), autoscrolling(false)
+{
+}
+
+// The digit count of the display is only known after its begin().
+byte SevSeg_MAX7219_Viewport::width(void)
+{
+  byte total = sevSeg.digitCount();
+  if (first >= total) return 0;
+  return (count < total - first) ? count : total - first;
+}
+
+void SevSeg_MAX7219_Viewport::clear(void)
+{
+  sevSeg.clearRange(first, width());
+  pos = 0;
+}
+
+void SevSeg_MAX7219_Viewport::home(void)
+{
+  pos = 0;
+}
+
+void SevSeg_MAX7219_Viewport::setCursor(byte x)
+{
+  pos = x;
+}
+
+void SevSeg_MAX7219_Viewport::autoScroll(void)
+{
+  autoscrolling = true;
+}
+
+void SevSeg_MAX7219_Viewport::noAutoScroll(void)
+{
+  autoscrolling = false;
+}
+
+void SevSeg_MAX7219_Viewport::displayChar(char digit, char character, bool dp)
+{
+  if ((byte) digit < width()) sevSeg.displayChar(first + digit, character, dp);
+}
+
+void SevSeg_MAX7219_Viewport::displayText(const char * text, bool rightjustify)
+{
+  sevSeg.displayTextRange(first, width(), text, rightjustify);
+}
+
+void SevSeg_MAX7219_Viewport::displayNumber(int32_t value, bool leadingZeros)
+{
+  displayFixed(value, 0, leadingZeros);
+}
+
+void SevSeg_MAX7219_Viewport::displayFixed(int32_t value, uint8_t decimals, bool leadingZeros)
+{
+  uint32_t magnitude = (value < 0) ? -(uint32_t) value : value;
+  sevSeg.displayDigits(first, width(), magnitude, 10, value < 0, decimals, leadingZeros);
+}
+
+void SevSeg_MAX7219_Viewport::displayHex(uint32_t value, bool leadingZeros)
+{
+  sevSeg.displayDigits(first, width(), value, 16, false, 0, leadingZeros);
+}
+
+size_t SevSeg_MAX7219_Viewport::write(uint8_t ch)
+{
+  sevSeg.writeRange(first, width(), pos, autoscrolling, ch);
+  return 1;
+}
+
+size_t SevSeg_MAX7219_Viewport::write(const uint8_t * buffer, size_t size)
+{
+  byte n = width();
+  sevSeg.beginWrite();
+  for (size_t i = 0; i < size; i++)
+    sevSeg.writeRange(first, n, pos, autoscrolling, buffer[i]);
+  sevSeg.endWrite();
+  return size;
+}
@@ -60,8 +60,8 @@
 *           abcdefg
 *           0110000
 *
-*           The table below contains all the binary values for the desired font. New font characters
-*           can be added or altered as required.
+*           The fonts in SevSeg_MAX7219.cpp contain the binary values for the characters. Custom fonts
+*           are tables in PROGMEM covering a contiguous range of characters, see setFont().
 *
 *           The DP bit is used to switch on the decimal place LED. DP is not included in the below table
 *           but is added in the register within the library depending on the content being displayed.
@@ -70,18 +70,37 @@
 */
 
 #include <Print.h>
+#include "SevSeg_MAX7219_Bus.h"
+
+// built-in fonts, ' ' to '}' and ' ' to '\xb0' (degree sign)
+extern const uint8_t SevSeg_MAX7219_Font[] PROGMEM;
+extern const uint8_t SevSeg_MAX7219_FontExtended[] PROGMEM;
+
+// What to do with characters the font does not cover
+enum SevSeg_MAX7219_Fallback {
+  SEVSEG_FALLBACK_BLANK,  // show an empty digit
+  SEVSEG_FALLBACK_GLYPH,  // show a replacement pattern
+  SEVSEG_FALLBACK_SKIP    // ignore the character, nothing is written
+};
+
+class SevSeg_MAX7219_Viewport;
 
 
 class SevSeg_MAX7219 : public Print
 {
 public:
 
-  SevSeg_MAX7219(byte _dinPin, byte _clkPin, byte _csPin);
+  // _devices: number of daisy-chained MAX7219 (DOUT to DIN) sharing one CS
+  SevSeg_MAX7219(byte _dinPin, byte _clkPin, byte _csPin, byte _devices = 1); // bitbang
+  SevSeg_MAX7219(byte _csPin, byte _devices = 1);                             // hardware SPI
+  SevSeg_MAX7219(SevSeg_MAX7219_Bus & _bus, byte _csPin, byte _devices = 1);  // custom transport
+  ~SevSeg_MAX7219();
 
   void begin(byte ndigits = 4);
   void clear(void);
 
   void brightness(byte brightness);
+  void scanLimit(byte ndigits);
   void display(void);
   void noDisplay(void);
 
@@ -94,26 +113,246 @@ public:
   void displayChar(char digit, char character, bool dp);
   void displayText(const char * text, bool rightjustify = false);
 
+  // right justified numbers without String or float formatting
+  void displayNumber(int32_t value, bool leadingZeros = false);
+  void displayFixed(int32_t value, uint8_t decimals, bool leadingZeros = false);
+  void displayHex(uint32_t value, bool leadingZeros = false);
+
+  // Let the chip's Code B decoder show the digit rows in mask (bit 0 = digit
+  // 0, on all chained chips). Only 0-9 - E H L P and blank can be shown.
+  void decodeDigits(byte mask);
+  // Decode automatically: numbers switch all rows to Code B, other
+  // characters switch their row back. This skips font lookups but costs bus
+  // traffic: every switch sends the decode register and resends the
+  // switched rows, also with diffUpdates(). Only worth it if the display
+  // rarely alternates between numbers and text.
+  void autoDecode(void);
+  void noAutoDecode(void);
+
+  // table: segment patterns (dp a b c d e f g) in PROGMEM for characters first..last
+  void setFont(const uint8_t * table, char first, char last);
+  void setFallback(SevSeg_MAX7219_Fallback policy, byte glyph = 0B00001000);
+
   void testMode(void);
   void noTestMode(void); 
 
+  // collect changes and transmit them in one go
+  void beginUpdate(void);
+  void commit(void);
+
+  // Compose in a back buffer and show it with swap(), e.g. when digits are
+  // written from an interrupt handler. Needs another 8 bytes per chip.
+  // Writers in interrupt handlers must not use autoDecode().
+  void doubleBuffer(void);
+  void noDoubleBuffer(void);
+  void swap(void);
+
+  // only transmit digits whose segments changed
+  void diffUpdates(void);
+  void noDiffUpdates(void);
+  unsigned long suppressedWrites(void);
+
+  // non-blocking animations, call tick() from loop()
+  void scrollText(const char * text, unsigned int interval = 300);
+  void noScrollText(void);
+  void blink(byte mask, unsigned int interval = 500);
+  void noBlink(void);
+  void fadeBrightness(byte brightness, unsigned int duration);
+  // Brightness in 1/16 steps of the 16 chip levels (0 - 255). Levels between
+  // two chip levels need dither() and a frequent tick().
+  void fineBrightness(byte level);
+  void fadeFineBrightness(byte level, unsigned int duration);
+  void dither(void);
+  void noDither(void);
+  void tick(unsigned long now = millis());
+
+  // rewrite all registers within period ms from tick(), one per step
+  void refresh(unsigned int period = 1000);
+  void noRefresh(void);
+
   // Print class support
   virtual size_t write(uint8_t);
+  virtual size_t write(const uint8_t * buffer, size_t size);
+  using Print::write;
 
 protected:
 
-  byte dinPin;
-  byte clkPin;
+  friend class SevSeg_MAX7219_Viewport;
+  friend class SevSeg_MAX7219_Bus;
+
+  SevSeg_MAX7219_SoftBus * softBus;  // bitbang bus owned by the display, or NULL
+  SevSeg_MAX7219_Bus * bus;
   byte csPin;
 
-  byte digits;        // number of digits (starting at 0, max 8)
+  byte devices;       // number of chained chips
+  byte digits;        // number of digits per chip (starting at 0, max 8)
   byte pos;           // virtual cursor position
   bool autoscrolling; // automatically scroll at the end of the display
   bool justify;       // right justify text?
-  char buf[8];        // current 7 segment contents
+  char * buf;         // current 7 segment contents, 8 per chip
+  char * front;       // contents to transmit, buf unless double buffering
+  char * sent;        // segments last transmitted to the chips, 8 per chip
+  byte * dirty;       // digits changed since the last flush, one bitmask per chip
+  byte deferred;      // nesting level of beginUpdate()
+  SevSeg_MAX7219 * nextOnBus; // next display sharing the bus
+  bool diffing;       // skip digits which did not change?
+  unsigned long suppressed; // number of digit writes skipped
+  const uint8_t * font;
+  byte fontFirst;
+  byte fontLast;
+  byte fallbackGlyph; // pattern for characters outside the font
+  bool skipUnknown;   // ignore characters outside the font?
+  byte control[7];    // control registers 0x09 - 0x0f as last written
+  byte unsent;        // control registers not written since begin(), bit 0 = 0x09
+  byte lost;          // control registers whose last write the bus dropped
+  byte fineLevel;     // brightness in 1/16 steps
+  byte decodeMask;    // digit rows in Code B mode; buf[] holds Code B for them
+  bool autoDecoding;
 
+  byte * marquee;               // ring of segments scrolling through the display
+  unsigned int marqueeSize;     // allocated size of marquee
+  unsigned int marqueeLength;   // segments in the ring, 0 if not scrolling
+  unsigned int marqueeStep;     // position in the ring
+  unsigned int marqueeInterval;
+  unsigned long marqueeTime;    // time of the last step
+  byte blinkMask;               // digit rows which blink
+  bool blinkOff;                // blinking digits currently dark?
+  unsigned int blinkInterval;
+  unsigned long blinkTime;
+  byte fadeFrom;                // brightness ramp, in 1/16 steps
+  byte fadeTo;
+  unsigned int fadeDuration;    // 0 if not fading
+  unsigned long fadeStart;
+  bool dithering;               // alternate between adjacent levels?
+  byte ditherError;             // accumulated fraction, 1/16 steps
+  unsigned int refreshPeriod;   // time to rewrite all registers, 0 if off
+  unsigned long refreshTime;    // time of the last register rewrite
+  byte refreshNext;             // digit row, then control register to rewrite
+
+  void init(byte _devices);
+  byte digitCount(void) { return digits * devices; }
+  bool deferring(void) { return deferred || bus->deferred; }
+
+  void beginWrite(void);
+  void endWrite(void);
   void writeSPI(byte opcode, byte data);
+  void writeDigit(byte digit);
+  void setDigit(byte digit, byte code);
+  void sendRow(byte row);
+  char output(byte i) { return (blinkOff && (blinkMask & (1 << (i % digits)))) ? blank(i) : front[i]; }
+  void flush(void);
+  void resendLost(void);
   byte lookup(char c, bool dp);
+  bool decoded(byte digit) { return decodeMask & (1 << (digit % digits)); }
+  byte blank(byte digit) { return decoded(digit) ? 0x0f : 0x00; }
+  byte glyph(byte digit, char c, bool dp);
+  byte encode(byte digit, byte segments);
+  byte segments(byte digit);
+  bool skipped(char c) { return skipUnknown && (byte) ((byte) c - fontFirst) > fontLast - fontFirst; }
+  const char * nextChar(const char * p, char & c, bool & dp);
+  void renderMarquee(void);
+  void refreshRegister(void);
+
+  // the digits first..first+count-1, for the display and its viewports
+  void clearRange(byte first, byte count);
+  void writeRange(byte first, byte count, byte & cursor, bool scrolling, uint8_t ch);
+  void displayTextRange(byte first, byte count, const char * text, bool rightjustify);
+  void displayDigits(byte first, byte count, uint32_t value, byte base, bool negative, uint8_t decimals, bool leadingZeros);
+
+private:
+
+  // The buffers and the bitbang bus belong to one object: not copyable,
+  // pass displays by reference.
+  SevSeg_MAX7219(const SevSeg_MAX7219 &);
+  SevSeg_MAX7219 & operator=(const SevSeg_MAX7219 &);
+
+};
+
+
+/*
+*********************************************************************************************************
+* SevSeg_MAX7219_Viewport: a field of count digits starting at digit first, with its own cursor, e.g.
+* a value and a unit on one 8 digit module:
+*
+*   SevSeg_MAX7219_Viewport value(sevSeg, 0, 5);
+*   SevSeg_MAX7219_Viewport unit(sevSeg, 5, 3);
+*
+* Text and numbers are justified within the field and only its digits are transmitted. All viewports
+* share the buffers, fonts, animations and the bus of the display.
+*********************************************************************************************************
+*/
+
+class SevSeg_MAX7219_Viewport : public Print
+{
+public:
+
+  SevSeg_MAX7219_Viewport(SevSeg_MAX7219 & _display, byte _first, byte _count);
+
+  void clear(void);
+  void home(void);
+  void setCursor(byte x);
+  void autoScroll(void);
+  void noAutoScroll(void);
+
+  void displayChar(char digit, char character, bool dp);
+  void displayText(const char * text, bool rightjustify = false);
+  void displayNumber(int32_t value, bool leadingZeros = false);
+  void displayFixed(int32_t value, uint8_t decimals, bool leadingZeros = false);
+  void displayHex(uint32_t value, bool leadingZeros = false);
+
+  // Print class support
+  virtual size_t write(uint8_t);
+  virtual size_t write(const uint8_t * buffer, size_t size);
+  using Print::write;
+
+protected:
+
+  SevSeg_MAX7219 & sevSeg;
+  byte first;         // first digit of the field
+  byte count;         // number of digits
+  byte pos;           // cursor position within the field
+  bool autoscrolling;
+
+  byte width(void);
+
+};
+
+
+/*
+*********************************************************************************************************
+* SevSeg_MAX7219_T: same interface as SevSeg_MAX7219 with the pins and the default number of digits
+* given as template arguments, e.g.
+*
+*   SevSeg_MAX7219_T<12, 11, 10, 8> sevSeg;
+*
+* The bus code is generated for the fixed pins. On the ATmega168/328P this turns every pin access into
+* a single sbi/cbi instruction: no pin-to-port table reads in flash, no port pointers in RAM and no
+* interrupt masking, and shifting a register word is several times faster than the generic bitbang bus.
+* DIGITS is only the default argument of begin(), the number of digits is still set at runtime.
+*
+* RAM on AVR: the digit buffers are the same as for SevSeg_MAX7219. The fixed pin bus adds 6 bytes to
+* the object (vtable pointer and the bus state shared by all buses), where SevSeg_MAX7219(din, clk, cs)
+* allocates an 18 byte bitbang bus on the heap. On other AVRs the fixed pin bus is that bitbang bus,
+* 18 bytes in the object.
+*********************************************************************************************************
+*/
+
+// A base class, not a member: bases are constructed in order and destroyed
+// in reverse, so the bus exists for the whole life of the display.
+template<byte DIN, byte CLK, byte CS>
+struct SevSeg_MAX7219_FastBusHolder
+{
+  SevSeg_MAX7219_FastBus<DIN, CLK, CS> fastBus;
+};
+
+template<byte DIN, byte CLK, byte CS, byte DIGITS = 8>
+class SevSeg_MAX7219_T : protected SevSeg_MAX7219_FastBusHolder<DIN, CLK, CS>, public SevSeg_MAX7219
+{
+public:
+
+  SevSeg_MAX7219_T(byte _devices = 1) : SevSeg_MAX7219(this->fastBus, CS, _devices) { }
+
+  void begin(byte ndigits = DIGITS) { SevSeg_MAX7219::begin(ndigits); }
 
 };
 
@@ -0,0 +1,174 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2020 Bastian Maerkisch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+********************************************************************************
+*
+* Module         : SevSeg_MAX7219_Async.cpp
+* Description    : Interrupt driven, non-blocking transport for the MAX7219
+*
+*  - The queue has a single producer (the caller) and a single consumer
+*    (step()). head and tail are bytes, so they are updated atomically.
+*  - The SPI clock defaults to 1 MHz: at higher rates the interrupt overhead
+*    per byte exceeds the transfer time and nothing is gained.
+*/
+
+#include <SPI.h>
+#include "SevSeg_MAX7219_Async.h"
+
+#define QUEUE_MASK  (SEVSEG_MAX7219_QUEUE_SIZE - 1)
+
+// The vector itself is defined by the sketch, see SEVSEG_MAX7219_ASYNC_ISR.
+#if defined(__AVR__) && defined(SPI_STC_vect)
+#define INTERRUPT_DRIVEN
+#endif
+
+
+SevSeg_MAX7219_AsyncBus::SevSeg_MAX7219_AsyncBus(SevSeg_MAX7219_QueuePolicy _policy, uint32_t _clock) :
+  policy(_policy), clock(_clock),
+  head(0), tail(0), stage(0), overflow(false), busy(false),
+  remaining(0), currentCs(0), dropped(0)
+{
+}
+
+void SevSeg_MAX7219_AsyncBus::begin(void)
+{
+  SPI.begin();
+  SPI.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE0));
+#if defined(INTERRUPT_DRIVEN)
+  SPCR |= _BV(SPIE);
+#endif
+}
+
+void SevSeg_MAX7219_AsyncBus::select(byte csPin)
+{
+  // leave room for the frame header
+  stage = head + 2;
+  overflow = false;
+}
+
+void SevSeg_MAX7219_AsyncBus::transfer16(uint16_t data)
+{
+  if (overflow) return;
+  while ((byte) (stage + 2 - tail) > SEVSEG_MAX7219_QUEUE_SIZE) {
+    // Waiting only helps if frames are still being sent, i.e. the SPI
+    // interrupt can run.
+    if (policy == SEVSEG_QUEUE_DROP || !busy || !canWait()) {
+      overflow = true;
+      return;
+    }
+    wait();
+  }
+  queue[stage++ & QUEUE_MASK] = data >> 8;
+  queue[stage++ & QUEUE_MASK] = data & 0xff;
+}
+
+bool SevSeg_MAX7219_AsyncBus::deselect(byte csPin)
+{
+  byte words = (byte) (stage - head - 2) / 2;
+  if (overflow) {
+    dropped++;
+    return false;
+  }
+  if (words == 0) return true;
+  queue[head & QUEUE_MASK] = csPin;
+  queue[(head + 1) & QUEUE_MASK] = words;
+
+#if defined(__AVR__)
+  uint8_t oldSREG = SREG;
+  cli();
+#else
+  noInterrupts();
+#endif
+  head = stage;
+  if (!busy) startFrame();
+#if defined(__AVR__)
+  SREG = oldSREG;
+#else
+  interrupts();
+#endif
+  return true;
+}
+
+void SevSeg_MAX7219_AsyncBus::waitIdle(void)
+{
+  while (busy) wait();
+}
+
+// With interrupts disabled, e.g. in an interrupt handler, the queue does
+// not drain by itself.
+bool SevSeg_MAX7219_AsyncBus::canWait(void)
+{
+#if defined(INTERRUPT_DRIVEN)
+  return SREG & _BV(SREG_I);
+#else
+  return true;
+#endif
+}
+
+void SevSeg_MAX7219_AsyncBus::wait(void)
+{
+#if !defined(INTERRUPT_DRIVEN)
+  step();
+#endif
+}
+
+void SevSeg_MAX7219_AsyncBus::step(void)
+{
+  if (!busy) return;
+  if (remaining > 0) {
+    remaining--;
+    shiftByte(queue[tail++ & QUEUE_MASK]);
+    return;
+  }
+  // The last byte of the frame has been sent: latch it.
+  csWrite(currentCs, HIGH);
+  startFrame();
+}
+
+// Must not be interrupted by step().
+void SevSeg_MAX7219_AsyncBus::startFrame(void)
+{
+  if (tail == head) {
+    busy = false;
+    return;
+  }
+  busy = true;
+  currentCs = queue[tail++ & QUEUE_MASK];
+  remaining = 2 * queue[tail++ & QUEUE_MASK] - 1;
+  csWrite(currentCs, LOW);
+  shiftByte(queue[tail++ & QUEUE_MASK]);
+}
+
+void SevSeg_MAX7219_AsyncBus::shiftByte(byte data)
+{
+#if defined(INTERRUPT_DRIVEN)
+  SPDR = data;
+#else
+  SPI.transfer(data);
+#endif
+}
+
+void SevSeg_MAX7219_AsyncBus::csWrite(byte csPin, byte level)
+{
+  digitalWrite(csPin, level);
+}
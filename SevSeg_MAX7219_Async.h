@@ -0,0 +1,123 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Bastian Maerkisch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************
+ *
+ * Module         : SevSeg_MAX7219_Async.h
+ * Description    : Interrupt driven, non-blocking transport for the MAX7219
+ *
+ ********************************************************************************
+ */
+
+#ifndef SevSeg_MAX7219_Async_h
+#define SevSeg_MAX7219_Async_h
+
+#include "SevSeg_MAX7219_Bus.h"
+
+/*
+*********************************************************************************************************
+* SevSeg_MAX7219_AsyncBus queues the register words and returns immediately. On AVR the SPI transfer
+* complete interrupt shifts out the queue byte by byte and toggles CS between frames, so the caller only
+* pays for copying the words. The bus takes over the SPI peripheral: no other SPI device can be used.
+* The library does not claim the interrupt vector, so that it stays free for sketches without an
+* AsyncBus. The sketch connects it to its bus, once, at file scope:
+*
+*   SevSeg_MAX7219_AsyncBus bus;
+*   SEVSEG_MAX7219_ASYNC_ISR(bus)
+*
+* Without it the first transfer complete interrupt jumps to the default handler, which resets the MCU.
+*
+* Elsewhere, or for testing, the queue is drained by calling step() until isBusy() returns false.
+*
+* When the queue is full a frame either waits for space (SEVSEG_QUEUE_BLOCK) or is dropped as a whole
+* (SEVSEG_QUEUE_DROP) and counted. A frame never gets split or partially sent. With interrupts disabled
+* the queue cannot drain, so there frames are dropped under either policy, and waitIdle() must not be
+* called.
+*********************************************************************************************************
+*/
+
+#ifndef SEVSEG_MAX7219_QUEUE_SIZE
+#define SEVSEG_MAX7219_QUEUE_SIZE  64    // bytes, power of two up to 128; a frame takes 2 + 2 per chip
+#endif
+
+// The queue positions are bytes: the fill level of a larger queue would wrap around.
+#if SEVSEG_MAX7219_QUEUE_SIZE > 128 || (SEVSEG_MAX7219_QUEUE_SIZE & (SEVSEG_MAX7219_QUEUE_SIZE - 1)) != 0
+#error "SEVSEG_MAX7219_QUEUE_SIZE must be a power of two up to 128"
+#endif
+
+#if defined(__AVR__) && defined(SPI_STC_vect)
+#define SEVSEG_MAX7219_ASYNC_ISR(bus)  ISR(SPI_STC_vect) { (bus).step(); }
+#endif
+
+enum SevSeg_MAX7219_QueuePolicy {
+  SEVSEG_QUEUE_BLOCK,     // wait until the frame fits
+  SEVSEG_QUEUE_DROP       // discard the frame
+};
+
+
+class SevSeg_MAX7219_AsyncBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  SevSeg_MAX7219_AsyncBus(SevSeg_MAX7219_QueuePolicy _policy = SEVSEG_QUEUE_BLOCK,
+                          uint32_t _clock = 1000000);
+
+  virtual void begin(void);
+  virtual void select(byte csPin);
+  virtual void transfer16(uint16_t data);
+  virtual bool deselect(byte csPin);
+
+  bool isBusy(void) { return busy; }
+  void waitIdle(void);
+  unsigned long droppedFrames(void) { return dropped; }
+
+  // Advance the transmission by one byte. Called by the interrupt handler on AVR.
+  void step(void);
+
+protected:
+
+  SevSeg_MAX7219_QueuePolicy policy;
+  uint32_t clock;
+
+  byte queue[SEVSEG_MAX7219_QUEUE_SIZE]; // frames: CS pin, word count, words MSB first
+  volatile byte head;     // end of the queued frames, written by the caller
+  volatile byte tail;     // next byte to send, written by step()
+  byte stage;             // end of the frame being queued
+  bool overflow;          // the frame being queued does not fit
+  volatile bool busy;     // a frame is being sent
+
+  byte remaining;         // bytes left in the current frame
+  byte currentCs;         // CS pin of the current frame
+
+  unsigned long dropped;
+
+  void startFrame(void);
+  bool canWait(void);
+  void wait(void);
+
+  // hardware access, replaceable for testing
+  virtual void shiftByte(byte data);
+  virtual void csWrite(byte csPin, byte level);
+
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2020 Bastian Maerkisch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+********************************************************************************
+*
+* Module         : SevSeg_MAX7219_Bus.cpp
+* Description    : Transports used to talk to the MAX7219
+*
+*  - SevSeg_MAX7219_SoftBus shifts the data out on two arbitrary pins. On AVR
+*    the pins are looked up once and toggled through their port registers,
+*    which is about an order of magnitude faster than digitalWrite/shiftOut.
+*  - SevSeg_MAX7219_SPIBus uses the SPI peripheral. The MAX7219 accepts up to
+*    10 MHz, SPI mode 0, MSB first.
+*/
+
+#include <SPI.h>
+#include "SevSeg_MAX7219_Bus.h"
+#include "SevSeg_MAX7219.h"
+
+
+// Displays still on the bus forget it, so that they can be destroyed later.
+SevSeg_MAX7219_Bus::~SevSeg_MAX7219_Bus()
+{
+  for (SevSeg_MAX7219 * d = displays; d != NULL; d = d->nextOnBus)
+    d->bus = NULL;
+}
+
+void SevSeg_MAX7219_Bus::beginUpdate(void)
+{
+  deferred++;
+}
+
+// Send the changes of all displays on the bus, row by row, so that they
+// show the new contents at about the same time. Like flush(), the pass
+// stays deferred, so a writer interrupting it cannot start its own.
+void SevSeg_MAX7219_Bus::commit(void)
+{
+  if (deferred > 1) {
+    deferred--;
+    return;
+  }
+  deferred = 1;
+  for (SevSeg_MAX7219 * d = displays; d != NULL; d = d->nextOnBus) {
+    if (!d->deferred) d->resendLost();
+  }
+  for (byte row = 0; row < 8; row++) {
+    for (SevSeg_MAX7219 * d = displays; d != NULL; d = d->nextOnBus) {
+      if (!d->deferred && row < d->digits) d->sendRow(row);
+    }
+  }
+  deferred = 0;
+}
+
+
+SevSeg_MAX7219_SoftBus::SevSeg_MAX7219_SoftBus(byte _dinPin, byte _clkPin) :
+  dinPin(_dinPin), clkPin(_clkPin)
+{
+#if defined(__AVR__)
+  // not NOT_A_PIN: that is 0, a valid CS pin
+  csCached = 0xff;
+#endif
+}
+
+#if defined(__AVR__)
+
+void SevSeg_MAX7219_SoftBus::begin(void)
+{
+  pinMode(dinPin, OUTPUT);
+  pinMode(clkPin, OUTPUT);
+  dinReg = portOutputRegister(digitalPinToPort(dinPin));
+  dinMask = digitalPinToBitMask(dinPin);
+  clkReg = portOutputRegister(digitalPinToPort(clkPin));
+  clkMask = digitalPinToBitMask(clkPin);
+}
+
+void SevSeg_MAX7219_SoftBus::select(byte csPin)
+{
+  if (csPin != csCached) {
+    csReg = portOutputRegister(digitalPinToPort(csPin));
+    csMask = digitalPinToBitMask(csPin);
+    csCached = csPin;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  *csReg &= ~csMask;
+  SREG = oldSREG;
+}
+
+void SevSeg_MAX7219_SoftBus::transfer16(uint16_t data)
+{
+  // The port registers are shared with other pins, so the read-modify-write
+  // cycles must not be interrupted.
+  uint8_t oldSREG = SREG;
+  cli();
+  for (uint16_t bit = 0x8000; bit != 0; bit >>= 1) {
+    if (data & bit)
+      *dinReg |= dinMask;
+    else
+      *dinReg &= ~dinMask;
+    *clkReg |= clkMask;
+    *clkReg &= ~clkMask;
+  }
+  SREG = oldSREG;
+}
+
+bool SevSeg_MAX7219_SoftBus::deselect(byte csPin)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  *csReg |= csMask;
+  SREG = oldSREG;
+  return true;
+}
+
+#else
+
+void SevSeg_MAX7219_SoftBus::begin(void)
+{
+  pinMode(dinPin, OUTPUT);
+  pinMode(clkPin, OUTPUT);
+}
+
+void SevSeg_MAX7219_SoftBus::select(byte csPin)
+{
+  digitalWrite(csPin, LOW);
+}
+
+void SevSeg_MAX7219_SoftBus::transfer16(uint16_t data)
+{
+  shiftOut(dinPin, clkPin, MSBFIRST, data >> 8);
+  shiftOut(dinPin, clkPin, MSBFIRST, data & 0xff);
+}
+
+bool SevSeg_MAX7219_SoftBus::deselect(byte csPin)
+{
+  digitalWrite(csPin, HIGH);
+  return true;
+}
+
+#endif
+
+
+static const SPISettings max7219SPISettings(10000000, MSBFIRST, SPI_MODE0);
+
+void SevSeg_MAX7219_SPIBus::begin(void)
+{
+  SPI.begin();
+}
+
+void SevSeg_MAX7219_SPIBus::select(byte csPin)
+{
+  SPI.beginTransaction(max7219SPISettings);
+  digitalWrite(csPin, LOW);
+}
+
+void SevSeg_MAX7219_SPIBus::transfer16(uint16_t data)
+{
+  SPI.transfer16(data);
+}
+
+bool SevSeg_MAX7219_SPIBus::deselect(byte csPin)
+{
+  digitalWrite(csPin, HIGH);
+  SPI.endTransaction();
+  return true;
+}
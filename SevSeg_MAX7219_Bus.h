@@ -0,0 +1,198 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Bastian Maerkisch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************
+ *
+ * Module         : SevSeg_MAX7219_Bus.h
+ * Description    : Transports used to talk to the MAX7219
+ *
+ ********************************************************************************
+ */
+
+#ifndef SevSeg_MAX7219_Bus_h
+#define SevSeg_MAX7219_Bus_h
+
+#if (ARDUINO >= 100)
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif
+
+/*
+*********************************************************************************************************
+* A bus moves 16-bit register words (opcode in the high byte, data in the low byte) to the MAX7219.
+* The device owns its CS pin; the bus frames a transaction between select() and deselect() and the
+* chip latches the last word on the rising edge of CS. deselect() returns false if the bus dropped the
+* frame instead of sending it; the display then sends it again with its next update.
+*
+*   SevSeg_MAX7219_SoftBus : bitbang on any two pins (DIN, CLK), writing the port registers
+*                            directly on AVR
+*   SevSeg_MAX7219_SPIBus  : hardware SPI peripheral (DIN = MOSI, CLK = SCK)
+*   SevSeg_MAX7219_FastBus : bitbang on pins fixed at compile time
+*
+* Custom transports (e.g. a mock for testing) derive from SevSeg_MAX7219_Bus.
+*
+* Several displays with their own CS pins can share one bus object. Its begin() is only called once,
+* and between beginUpdate() and commit() on the bus the changes of all displays are collected and sent
+* in one pass over the digit rows.
+*********************************************************************************************************
+*/
+
+class SevSeg_MAX7219;
+
+#if defined(__AVR__) && !defined(SEVSEG_MAX7219_PORT_REGISTER)
+// type of a port output register, the host tests substitute one which records writes
+#define SEVSEG_MAX7219_PORT_REGISTER volatile uint8_t
+#endif
+
+class SevSeg_MAX7219_Bus
+{
+public:
+
+  SevSeg_MAX7219_Bus() : started(false), deferred(0), displays(NULL) { }
+  virtual ~SevSeg_MAX7219_Bus();
+
+  virtual void begin(void) { }
+  virtual void select(byte csPin) = 0;
+  virtual void transfer16(uint16_t data) = 0;
+  virtual bool deselect(byte csPin) = 0;
+
+  // collect the changes of all displays on this bus
+  void beginUpdate(void);
+  void commit(void);
+
+protected:
+
+  friend class SevSeg_MAX7219;
+
+  bool started;                 // begin() called?
+  byte deferred;                // nesting level of beginUpdate()
+  SevSeg_MAX7219 * displays;    // displays which called begin(), linked by nextOnBus
+
+};
+
+
+class SevSeg_MAX7219_SoftBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  SevSeg_MAX7219_SoftBus(byte _dinPin, byte _clkPin);
+
+  virtual void begin(void);
+  virtual void select(byte csPin);
+  virtual void transfer16(uint16_t data);
+  virtual bool deselect(byte csPin);
+
+protected:
+
+  byte dinPin;
+  byte clkPin;
+
+#if defined(__AVR__)
+  // pins resolved to port registers in begin()
+  SEVSEG_MAX7219_PORT_REGISTER * dinReg;
+  SEVSEG_MAX7219_PORT_REGISTER * clkReg;
+  SEVSEG_MAX7219_PORT_REGISTER * csReg;
+  uint8_t dinMask;
+  uint8_t clkMask;
+  uint8_t csMask;
+  byte csCached;      // pin csReg/csMask belong to, 0xff before the first select()
+#endif
+
+};
+
+
+class SevSeg_MAX7219_SPIBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  virtual void begin(void);
+  virtual void select(byte csPin);
+  virtual void transfer16(uint16_t data);
+  virtual bool deselect(byte csPin);
+
+};
+
+
+/*
+*********************************************************************************************************
+* On the ATmega168/328P (Uno, Nano, Pro Mini) the port of a pin number is known at compile time, so
+* with constant pins every access compiles to a single sbi/cbi instruction, which is also atomic.
+* Elsewhere SevSeg_MAX7219_FastBus falls back to SevSeg_MAX7219_SoftBus with fixed pins.
+*********************************************************************************************************
+*/
+
+#if defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega328P__)
+
+#define SEVSEG_MAX7219_PORT(p)  ((p) < 8 ? &PORTD : (p) < 14 ? &PORTB : &PORTC)
+#define SEVSEG_MAX7219_MASK(p)  ((p) < 8 ? 1 << (p) : (p) < 14 ? 1 << ((p) - 8) : 1 << ((p) - 14))
+
+template<byte DIN, byte CLK, byte CS>
+class SevSeg_MAX7219_FastBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  virtual void begin(void)
+  {
+    pinMode(DIN, OUTPUT);
+    pinMode(CLK, OUTPUT);
+  }
+
+  virtual void select(byte csPin)
+  {
+    *SEVSEG_MAX7219_PORT(CS) &= ~SEVSEG_MAX7219_MASK(CS);
+  }
+
+  virtual void transfer16(uint16_t data)
+  {
+    for (uint16_t bit = 0x8000; bit != 0; bit >>= 1) {
+      if (data & bit)
+        *SEVSEG_MAX7219_PORT(DIN) |= SEVSEG_MAX7219_MASK(DIN);
+      else
+        *SEVSEG_MAX7219_PORT(DIN) &= ~SEVSEG_MAX7219_MASK(DIN);
+      *SEVSEG_MAX7219_PORT(CLK) |= SEVSEG_MAX7219_MASK(CLK);
+      *SEVSEG_MAX7219_PORT(CLK) &= ~SEVSEG_MAX7219_MASK(CLK);
+    }
+  }
+
+  virtual bool deselect(byte csPin)
+  {
+    *SEVSEG_MAX7219_PORT(CS) |= SEVSEG_MAX7219_MASK(CS);
+    return true;
+  }
+
+};
+
+#else
+
+template<byte DIN, byte CLK, byte CS>
+class SevSeg_MAX7219_FastBus : public SevSeg_MAX7219_SoftBus
+{
+public:
+
+  SevSeg_MAX7219_FastBus() : SevSeg_MAX7219_SoftBus(DIN, CLK) { }
+
+};
+
+#endif
+
+#endif
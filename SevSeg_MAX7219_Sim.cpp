@@ -0,0 +1,116 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2020 Bastian Maerkisch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+********************************************************************************
+*
+* Module         : SevSeg_MAX7219_Sim.cpp
+* Description    : Simulated MAX7219 chain for testing without hardware
+*
+*  - Only the serial interface and the registers are modelled, not the
+*    multiplexing of the LEDs.
+*  - The chip nearest to the MCU is chip 0. It receives the word shifted last.
+*/
+
+#include "SevSeg_MAX7219_Sim.h"
+
+
+SevSeg_MAX7219_SimBus::SevSeg_MAX7219_SimBus(byte _devices) :
+  frames(0), words(0), edges(0), din(false)
+{
+  chips = (SevSeg_MAX7219_SimChip *) malloc(_devices * sizeof(SevSeg_MAX7219_SimChip));
+  shift = (uint16_t *) malloc(_devices * sizeof(uint16_t));
+  count = (chips && shift) ? _devices : 0;
+  reset();
+}
+
+SevSeg_MAX7219_SimBus::~SevSeg_MAX7219_SimBus()
+{
+  free(chips);
+  free(shift);
+}
+
+void SevSeg_MAX7219_SimBus::reset(void)
+{
+  memset(chips, 0, count * sizeof(SevSeg_MAX7219_SimChip));
+  memset(shift, 0, count * sizeof(uint16_t));
+}
+
+void SevSeg_MAX7219_SimBus::select(byte csPin)
+{
+  edges++;
+}
+
+void SevSeg_MAX7219_SimBus::transfer16(uint16_t data)
+{
+  // what drops out of the last chip is lost
+  for (byte i = count; i-- > 1; )
+    shift[i] = shift[i - 1];
+  if (count > 0) shift[0] = data;
+  words++;
+
+  for (uint16_t bit = 0x8000; bit != 0; bit >>= 1) {
+    bool level = (data & bit) != 0;
+    if (level != din) edges++;
+    din = level;
+    edges += 2;
+  }
+}
+
+bool SevSeg_MAX7219_SimBus::deselect(byte csPin)
+{
+  for (byte i = 0; i < count; i++)
+    latch(chips[i], shift[i]);
+  frames++;
+  edges++;
+  return true;
+}
+
+// Segments of the Code B font: 0-9 - E H L P blank
+static const uint8_t codeBFont[16] PROGMEM = {
+  0x7e, 0x30, 0x6d, 0x79, 0x33, 0x5b, 0x5f, 0x70,
+  0x7f, 0x7b, 0x01, 0x4f, 0x37, 0x0e, 0x67, 0x00
+};
+
+byte SevSeg_MAX7219_SimBus::segments(byte n, byte digit)
+{
+  byte value = chips[n].digit[digit];
+  if (!(chips[n].decode & (1 << digit))) return value;
+  return pgm_read_byte(codeBFont + (value & 0x0f)) | (value & 0x80);
+}
+
+void SevSeg_MAX7219_SimBus::latch(SevSeg_MAX7219_SimChip & c, uint16_t data)
+{
+  byte reg = (data >> 8) & 0x0f;
+  byte value = data & 0xff;
+
+  switch (reg) {
+    case 0x00:                                   break;  // no-op
+    case 0x09: c.decode = value;                 break;
+    case 0x0a: c.intensity = value & 0x0f;       break;
+    case 0x0b: c.scanLimit = value & 0x07;       break;
+    case 0x0c: c.shutdown = value & 0x01;        break;
+    case 0x0f: c.test = value & 0x01;            break;
+    case 0x0d: case 0x0e:                        break;  // unused
+    default:   c.digit[reg - 1] = value;         break;
+  }
+}
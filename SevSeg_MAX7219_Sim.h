@@ -0,0 +1,97 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Bastian Maerkisch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************
+ *
+ * Module         : SevSeg_MAX7219_Sim.h
+ * Description    : Simulated MAX7219 chain for testing without hardware
+ *
+ ********************************************************************************
+ */
+
+#ifndef SevSeg_MAX7219_Sim_h
+#define SevSeg_MAX7219_Sim_h
+
+#include "SevSeg_MAX7219_Bus.h"
+
+/*
+*********************************************************************************************************
+* SevSeg_MAX7219_SimBus models a cascade of MAX7219 instead of driving pins. Every word shifted in
+* pushes the previous ones one chip further down the chain, and on deselect each chip latches the word
+* it holds, just like the real 16-bit shift registers. The decoded register contents can then be
+* inspected, e.g.
+*
+*   SevSeg_MAX7219_SimBus sim(2);
+*   SevSeg_MAX7219 sevSeg(sim, CS, 2);
+*   sevSeg.begin(8);
+*   sevSeg.print("HELLO");
+*   sim.chip(0).digit[0];   // segments of the leftmost digit
+*
+* Chips start in their power-up state: all control registers zero, i.e. shut down.
+*********************************************************************************************************
+*/
+
+struct SevSeg_MAX7219_SimChip
+{
+  byte digit[8];
+  byte decode;
+  byte intensity;
+  byte scanLimit;
+  byte shutdown;      // 0 = shut down, 1 = normal operation
+  byte test;
+};
+
+
+class SevSeg_MAX7219_SimBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  SevSeg_MAX7219_SimBus(byte _devices = 1);
+  ~SevSeg_MAX7219_SimBus();
+
+  virtual void select(byte csPin);
+  virtual void transfer16(uint16_t data);
+  virtual bool deselect(byte csPin);
+
+  void reset(void);   // power cycle all chips
+  byte devices(void) { return count; }
+  const SevSeg_MAX7219_SimChip & chip(byte n) { return chips[n]; }
+  byte segments(byte n, byte digit);    // lit segments, dp a b c d e f g
+
+  unsigned long frames;   // number of CS windows (two CS edges each)
+  unsigned long words;    // number of 16-bit words shifted
+  unsigned long edges;    // pin edges a bitbang bus needs: CS, CLK and DIN changes
+
+  void resetCounters(void) { frames = words = edges = 0; }
+
+protected:
+
+  byte count;
+  SevSeg_MAX7219_SimChip * chips;
+  uint16_t * shift;       // shift register contents, chip 0 first
+  bool din;               // level of DIN after the last bit
+
+  void latch(SevSeg_MAX7219_SimChip & c, uint16_t data);
+
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Module         : benchmark.cpp
+ * Description    : Bus traffic of the public calls, measured on the simulated chain
+ *
+ * For every call the number of CS windows (frames), CS toggles, 16-bit words
+ * and pin edges, plus the time each transport needs for them at F_CPU. The
+ * program fails if a call needs more frames or words than its budget, so
+ * ctest catches traffic regressions. Lower the budgets after improvements.
+ */
+
+#include <stdio.h>
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+
+#define DEVICES 1
+
+static SevSeg_MAX7219_SimBus sim(DEVICES);
+static SevSeg_MAX7219 sevSeg(sim, 10, DEVICES);
+
+// Estimated AVR CPU cycles per bit, per 16-bit word and per CS window
+// (select + deselect) of each transport.
+struct Transport {
+  const char * name;
+  unsigned bit, word, frame;
+};
+
+static const Transport transports[] = {
+  { "shiftOut",    180,  20, 120 },  // digitalWrite: ~60 cycles each, 3 per bit
+  { "port",         14,  12,  40 },  // SevSeg_MAX7219_SoftBus on AVR
+  { "HW SPI",        2,  40, 160 },  // SPI clock F_CPU/2, transaction overhead
+};
+
+static const int TRANSPORTS = sizeof(transports) / sizeof(transports[0]);
+
+static int overBudget;
+
+static void header(void)
+{
+  printf("%-20s %6s %6s %6s %6s", "call", "frames", "CS", "words", "edges");
+  for (int i = 0; i < TRANSPORTS; i++)
+    printf(" %9s", transports[i].name);
+  printf("\n");
+}
+
+// Report the traffic since the last call and check it against the budget.
+static void report(const char * call, unsigned long maxFrames, unsigned long maxWords)
+{
+  printf("%-20s %6lu %6lu %6lu %6lu", call, sim.frames, 2 * sim.frames, sim.words, sim.edges);
+  for (int i = 0; i < TRANSPORTS; i++) {
+    const Transport & t = transports[i];
+    unsigned long cycles = sim.words * (16UL * t.bit + t.word) + sim.frames * t.frame;
+    printf(" %6lu us", cycles / (F_CPU / 1000000UL));
+  }
+  if (sim.frames > maxFrames || sim.words > maxWords) {
+    printf("  over budget: %lu frames, %lu words", maxFrames, maxWords);
+    overBudget++;
+  }
+  printf("\n");
+  sim.resetCounters();
+}
+
+int main(void)
+{
+  header();
+
+  sevSeg.begin(8);
+  report("begin", 13, 13);
+
+  sevSeg.clear();
+  report("clear", 8, 8);
+
+  sevSeg.displayText("95.67F", true);
+  report("displayText", 5, 5);
+
+  sevSeg.displayChar(0, 'H', false);
+  report("displayChar", 1, 1);
+
+  // numbers: generic Print path against the integer fast paths
+  sevSeg.clear();
+  sim.resetCounters();
+  sevSeg.print(123.45);
+  report("print(float)", 6, 6);
+
+  sevSeg.clear();
+  sim.resetCounters();
+  sevSeg.displayFixed(12345, 2);
+  report("displayFixed", 5, 5);
+
+  sevSeg.clear();
+  sim.resetCounters();
+  sevSeg.displayNumber(12345);
+  report("displayNumber", 5, 5);
+
+  sevSeg.clear();
+  sevSeg.autoScroll();
+  sevSeg.print("12345678");
+  sim.resetCounters();
+  sevSeg.write('9');
+  report("write, autoscroll", 8, 8);
+  sevSeg.noAutoScroll();
+
+  sevSeg.clear();
+  sevSeg.diffUpdates();
+  sevSeg.displayNumber(1234);
+  sim.resetCounters();
+  sevSeg.displayNumber(1235);
+  report("displayNumber, diff", 1, 1);
+
+  sim.resetCounters();
+  sevSeg.brightness(15);
+  report("brightness, same", 0, 0);
+
+  return overBudget ? 1 : 0;
+}
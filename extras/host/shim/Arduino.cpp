@@ -0,0 +1,145 @@
+/*
+ * Module         : Arduino.cpp
+ * Description    : Minimal Arduino core for building SevSeg_MAX7219 on a host
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+
+byte hostPinLevel[HOST_PINS];
+unsigned long hostPinWrites;
+unsigned long hostMillis;
+unsigned long hostMicros;
+bool hostInterrupts = true;
+
+SPIClass SPI;
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin < HOST_PINS) hostPinLevel[pin] = val ? HIGH : LOW;
+  hostPinWrites++;
+  SPI.record(val ? HOST_PIN_HIGH : HOST_PIN_LOW, pin);
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+{
+  for (uint8_t i = 0; i < 8; i++) {
+    uint8_t b = (bitOrder == LSBFIRST) ? i : 7 - i;
+    digitalWrite(dataPin, (val >> b) & 1);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+unsigned long millis(void)
+{
+  return hostMillis;
+}
+
+unsigned long micros(void)
+{
+  return hostMicros;
+}
+
+void delay(unsigned long ms)
+{
+  hostMillis += ms;
+  hostMicros += ms * 1000;
+}
+
+void SPIClass::beginTransaction(SPISettings _settings)
+{
+  settings = _settings;
+  record(HOST_SPI_BEGIN_TRANSACTION, settings.clock);
+}
+
+void SPIClass::endTransaction(void)
+{
+  record(HOST_SPI_END_TRANSACTION);
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  record(HOST_SPI_BYTE, data);
+  return 0;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data)
+{
+  record(HOST_SPI_WORD, data);
+  return 0;
+}
+
+void SPIClass::record(HostSPIEventType type, uint32_t value)
+{
+  if (events < HOST_SPI_LOG) {
+    log[events].type = type;
+    log[events].value = value;
+  }
+  events++;
+}
+
+size_t Print::write(const uint8_t * buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--) {
+    if (write(*buffer++)) n++;
+    else break;
+  }
+  return n;
+}
+
+size_t Print::print(long n, int base)
+{
+  if (base == DEC && n < 0) {
+    size_t t = print('-');
+    return t + printNumber(-(unsigned long) n, DEC);
+  }
+  return printNumber(n, base);
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char * str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  if (base < 2) base = 10;
+  do {
+    char c = n % base;
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(str);
+}
+
+// Like the Arduino core: sign, integer part, dot, then one write per digit.
+size_t Print::print(double number, int digits)
+{
+  size_t n = 0;
+
+  if (number < 0.0) {
+    n += print('-');
+    number = -number;
+  }
+  double rounding = 0.5;
+  for (int i = 0; i < digits; i++)
+    rounding /= 10.0;
+  number += rounding;
+
+  unsigned long int_part = (unsigned long) number;
+  double remainder = number - (double) int_part;
+  n += print(int_part);
+  if (digits > 0) n += print('.');
+  while (digits-- > 0) {
+    remainder *= 10.0;
+    unsigned int toPrint = (unsigned int) remainder;
+    n += print(toPrint);
+    remainder -= toPrint;
+  }
+  return n;
+}
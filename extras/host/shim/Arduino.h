@@ -0,0 +1,56 @@
+/*
+ * Module         : Arduino.h
+ * Description    : Minimal Arduino core for building SevSeg_MAX7219 on a host
+ *
+ * Pins, time and interrupts are plain variables the tests can inspect and set.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH      1
+#define LOW       0
+#define INPUT     0
+#define OUTPUT    1
+#define LSBFIRST  0
+#define MSBFIRST  1
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define NOT_A_PIN 0
+
+#define HOST_PINS 64
+
+extern byte hostPinLevel[HOST_PINS];     // last level written to each pin
+extern unsigned long hostPinWrites;      // number of digitalWrite() calls
+extern unsigned long hostMillis;         // time returned by millis()
+extern unsigned long hostMicros;         // time returned by micros()
+extern bool hostInterrupts;              // interrupts enabled?
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+
+// fake_avr.h maps them to SREG instead
+#if !defined(noInterrupts)
+#define noInterrupts()  (hostInterrupts = false)
+#define interrupts()    (hostInterrupts = true)
+#endif
+
+#include "Print.h"
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Module         : Print.h
+ * Description    : The parts of the Arduino Print class the library uses
+ *
+ * Numbers are split into write() calls the same way as by the Arduino core,
+ * so the bus traffic of print() matches the target.
+ */
+
+#ifndef Print_h
+#define Print_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+
+class Print
+{
+public:
+
+  virtual ~Print() { }
+
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t * buffer, size_t size);
+  size_t write(const char * str) { return str ? write((const uint8_t *) str, strlen(str)) : 0; }
+  size_t write(const char * buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+
+  size_t print(const char * str) { return write(str); }
+  size_t print(char c) { return write((uint8_t) c); }
+  size_t print(int n, int base = DEC) { return print((long) n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+  size_t print(double n, int digits = 2);
+
+private:
+
+  size_t printNumber(unsigned long n, uint8_t base);
+
+};
+
+#endif
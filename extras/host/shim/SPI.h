@@ -0,0 +1,68 @@
+/*
+ * Module         : SPI.h
+ * Description    : Host SPI peripheral, records transfers, transactions and pin writes
+ */
+
+#ifndef SPI_h
+#define SPI_h
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+
+  SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) { }
+  SPISettings(uint32_t _clock, uint8_t _bitOrder, uint8_t _dataMode) :
+    clock(_clock), bitOrder(_bitOrder), dataMode(_dataMode) { }
+
+  uint32_t clock;
+  uint8_t bitOrder;
+  uint8_t dataMode;
+
+};
+
+enum HostSPIEventType {
+  HOST_SPI_BEGIN_TRANSACTION,   // value: clock
+  HOST_SPI_END_TRANSACTION,
+  HOST_SPI_BYTE,                // value: byte sent
+  HOST_SPI_WORD,                // value: word sent by transfer16()
+  HOST_PIN_LOW,                 // value: pin, from digitalWrite()
+  HOST_PIN_HIGH
+};
+
+struct HostSPIEvent
+{
+  HostSPIEventType type;
+  uint32_t value;
+};
+
+#define HOST_SPI_LOG 512
+
+// Pin writes are logged too, so that the order of CS and the transfers
+// can be checked.
+class SPIClass
+{
+public:
+
+  void begin(void) { }
+  void end(void) { }
+  void beginTransaction(SPISettings _settings);
+  void endTransaction(void);
+  uint8_t transfer(uint8_t data);
+  uint16_t transfer16(uint16_t data);
+
+  void record(HostSPIEventType type, uint32_t value = 0);
+  void clearLog(void) { events = 0; }
+
+  SPISettings settings;           // of the last beginTransaction()
+  HostSPIEvent log[HOST_SPI_LOG];
+  unsigned int events;            // number of events, only the first HOST_SPI_LOG are kept
+
+};
+
+extern SPIClass SPI;
+
+#endif
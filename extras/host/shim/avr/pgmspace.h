@@ -0,0 +1,17 @@
+/*
+ * Module         : avr/pgmspace.h
+ * Description    : Flash access on a host, where flash is ordinary memory
+ */
+
+#ifndef host_pgmspace_h
+#define host_pgmspace_h
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define pgm_read_byte(p)        (*(const uint8_t *) (p))
+#define pgm_read_byte_near(p)   pgm_read_byte(p)
+#define pgm_read_word(p)        (*(const uint16_t *) (p))
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * Module         : check.h
+ * Description    : Assertions for the host tests
+ */
+
+#ifndef check_h
+#define check_h
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+  do { \
+    long e_ = (long) (expected), a_ = (long) (actual); \
+    if (e_ != a_) { \
+      printf("%s:%d: %s is %ld, expected %ld\n", __FILE__, __LINE__, #actual, a_, e_); \
+      failures++; \
+    } \
+  } while (0)
+
+// return value of main()
+#define TEST_RESULT() (failures ? (printf("%d failure(s)\n", failures), 1) : 0)
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Module         : fake_avr.h
+ * Description    : AVR port registers and status register in memory
+ *
+ * Included ahead of every source of the *_avr tests, which are built with __AVR__
+ * defined. Pins map to ports like on the Uno: 0-7 PORTD, 8-13 PORTB, 14-19 PORTC.
+ */
+
+#ifndef fake_avr_h
+#define fake_avr_h
+
+#include <stdint.h>
+
+// A port output register which records every write.
+struct FakePort
+{
+  uint8_t value;
+
+  FakePort & operator|=(int mask) { value |= mask; written(); return *this; }
+  FakePort & operator&=(int mask) { value &= mask; written(); return *this; }
+  void written(void);
+};
+
+#define SEVSEG_MAX7219_PORT_REGISTER FakePort
+
+#define FAKE_PORTB 2
+#define FAKE_PORTC 3
+#define FAKE_PORTD 4
+
+extern FakePort fakePorts[5];
+extern uint8_t SREG;
+
+#define cli()                     (SREG &= ~0x80)
+#define sei()                     (SREG |= 0x80)
+#define noInterrupts()            cli()
+#define interrupts()              sei()
+#define portOutputRegister(port)  (&fakePorts[port])
+#define digitalPinToPort(pin)     ((pin) < 8 ? FAKE_PORTD : (pin) < 14 ? FAKE_PORTB : FAKE_PORTC)
+#define digitalPinToBitMask(pin)  (1 << ((pin) < 8 ? (pin) : (pin) < 14 ? (pin) - 8 : (pin) - 14))
+
+#endif
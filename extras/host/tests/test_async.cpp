@@ -0,0 +1,165 @@
+/*
+ * Module         : test_async.cpp
+ * Description    : Frames dropped by a full AsyncBus queue are sent again
+ *
+ * Built for the host and, with fake_avr.h, for the AVR status register code.
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Async.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+#if defined(__AVR__)
+FakePort fakePorts[5];
+uint8_t SREG = 0x80;
+
+void FakePort::written(void)
+{
+}
+#endif
+
+// An AsyncBus whose queue drains into a simulated chain.
+class SimAsyncBus : public SevSeg_MAX7219_AsyncBus
+{
+public:
+
+  SimAsyncBus(byte devices) : SevSeg_MAX7219_AsyncBus(SEVSEG_QUEUE_DROP), sim(devices), odd(false) { }
+
+  void drain(void) { while (isBusy()) step(); }
+
+  SevSeg_MAX7219_SimBus sim;
+
+protected:
+
+  bool odd;
+  byte high;
+
+  virtual void shiftByte(byte data)
+  {
+    if (odd) sim.transfer16((high << 8) | data);
+    high = data;
+    odd = !odd;
+  }
+  virtual void csWrite(byte csPin, byte level)
+  {
+    if (level == LOW)
+      sim.select(csPin);
+    else
+      sim.deselect(csPin);
+  }
+
+};
+
+static void checkChips(SevSeg_MAX7219_SimBus & expected, SevSeg_MAX7219_SimBus & actual)
+{
+  for (byte n = 0; n < expected.devices(); n++) {
+    const SevSeg_MAX7219_SimChip & e = expected.chip(n);
+    const SevSeg_MAX7219_SimChip & a = actual.chip(n);
+    CHECK_EQUAL(e.decode, a.decode);
+    CHECK_EQUAL(e.intensity, a.intensity);
+    CHECK_EQUAL(e.scanLimit, a.scanLimit);
+    CHECK_EQUAL(e.shutdown, a.shutdown);
+    CHECK_EQUAL(e.test, a.test);
+    for (byte d = 0; d < 8; d++)
+      CHECK_EQUAL(e.digit[d], a.digit[d]);
+  }
+}
+
+// begin() on two chips needs more frames than the queue holds, the last
+// ones turn the display on.
+static void testDroppedFrames(bool diffing)
+{
+  SevSeg_MAX7219_SimBus ref(2);
+  SevSeg_MAX7219 refSeg(ref, 10, 2);
+  SimAsyncBus bus(2);
+  SevSeg_MAX7219 sevSeg(bus, 10, 2);
+
+  refSeg.begin(8);
+  sevSeg.begin(8);
+  CHECK(bus.droppedFrames() > 0);
+  if (diffing) {
+    refSeg.diffUpdates();
+    sevSeg.diffUpdates();
+  }
+  refSeg.displayText("0123456789AbCdEF");
+  sevSeg.displayText("0123456789AbCdEF");
+
+  // nothing else is written: tick() sends what was dropped
+  unsigned long dropped;
+  int ticks = 0;
+  do {
+    dropped = bus.droppedFrames();
+    bus.drain();
+    sevSeg.tick();
+    ticks++;
+  } while (bus.droppedFrames() != dropped && ticks < 10);
+  bus.drain();
+  CHECK(ticks < 10);
+  checkChips(ref, bus.sim);
+
+  // and nothing more once it is through
+  bus.sim.resetCounters();
+  sevSeg.tick();
+  bus.drain();
+  CHECK_EQUAL(0, bus.sim.frames);
+}
+
+// The same when only the bus commits: the dropped control registers are
+// sent with the rows.
+static void testBusCommit(void)
+{
+  SevSeg_MAX7219_SimBus ref(2);
+  SevSeg_MAX7219 refSeg(ref, 10, 2);
+  SimAsyncBus bus(2);
+  SevSeg_MAX7219 sevSeg(bus, 10, 2);
+
+  refSeg.begin(8);
+  sevSeg.begin(8);
+  CHECK(bus.droppedFrames() > 0);
+
+  unsigned long dropped;
+  int commits = 0;
+  do {
+    dropped = bus.droppedFrames();
+    bus.drain();
+    bus.beginUpdate();
+    bus.commit();
+    commits++;
+  } while (bus.droppedFrames() != dropped && commits < 10);
+  bus.drain();
+  CHECK(commits < 10);
+  checkChips(ref, bus.sim);
+}
+
+#if defined(__AVR__)
+// Queuing a frame from an interrupt handler leaves interrupts disabled.
+static void testInterruptState(void)
+{
+  SimAsyncBus bus(1);
+  SevSeg_MAX7219 sevSeg(bus, 10);
+
+  sevSeg.begin(4);
+  bus.drain();
+  SREG = 0x00;
+  sevSeg.displayChar(0, '1', false);
+  CHECK_EQUAL(0x00, SREG);
+  SREG = 0x80;
+  sevSeg.displayChar(1, '2', false);
+  CHECK_EQUAL(0x80, SREG);
+  bus.drain();
+  CHECK_EQUAL(0x30, bus.sim.segments(0, 0));
+  CHECK_EQUAL(0x6d, bus.sim.segments(0, 1));
+}
+#endif
+
+int main(void)
+{
+  testDroppedFrames(false);
+  testDroppedFrames(true);
+  testBusCommit();
+#if defined(__AVR__)
+  testInterruptState();
+#endif
+  return TEST_RESULT();
+}
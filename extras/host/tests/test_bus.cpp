@@ -0,0 +1,223 @@
+/*
+ * Module         : test_bus.cpp
+ * Description    : Register words the display sends through a bus
+ */
+
+#include <new>
+#include <string.h>
+#include <type_traits>
+#include <SPI.h>
+#include <SevSeg_MAX7219.h>
+#include "check.h"
+
+// Records the words of each transaction, 0xffff marks the end of a frame.
+class MockBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  MockBus() : begun(0), n(0), open(false), badCs(0) { }
+
+  virtual void begin(void) { begun++; }
+  virtual void select(byte csPin)
+  {
+    if (open || csPin != 10) badCs++;
+    open = true;
+  }
+  virtual void transfer16(uint16_t data)
+  {
+    if (!open) badCs++;
+    if (n < 64) words[n++] = data;
+  }
+  virtual bool deselect(byte csPin)
+  {
+    if (!open || csPin != 10) badCs++;
+    open = false;
+    if (n < 64) words[n++] = 0xffff;
+    return true;
+  }
+
+  int begun;
+  uint16_t words[64];
+  int n;
+  bool open;
+  int badCs;
+
+};
+
+static void checkStream(MockBus & bus, const uint16_t * expected, int count)
+{
+  CHECK_EQUAL(count, bus.n);
+  for (int i = 0; i < count && i < bus.n; i++)
+    CHECK_EQUAL(expected[i], bus.words[i]);
+  CHECK_EQUAL(0, bus.badCs);
+  bus.n = 0;
+}
+
+static void testBegin(void)
+{
+  MockBus bus;
+  SevSeg_MAX7219 sevSeg(bus, 10);
+  static const uint16_t expected[] = {
+    0x0b03, 0xffff,     // scan limit: 4 digits
+    0x0900, 0xffff,     // no decoding
+    0x0100, 0xffff, 0x0200, 0xffff, 0x0300, 0xffff, 0x0400, 0xffff,
+    0x0f00, 0xffff,     // no test mode
+    0x0a0f, 0xffff,     // full brightness
+    0x0c01, 0xffff      // display on
+  };
+
+  sevSeg.begin();
+  CHECK_EQUAL(1, bus.begun);
+  checkStream(bus, expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void testDisplayText(void)
+{
+  MockBus bus;
+  SevSeg_MAX7219 sevSeg(bus, 10);
+  static const uint16_t left[] = {
+    0x0130, 0xffff, 0x02ed, 0xffff     // "12." from the left
+  };
+  static const uint16_t right[] = {
+    0x0330, 0xffff, 0x04ed, 0xffff
+  };
+
+  sevSeg.begin();
+  bus.n = 0;
+  sevSeg.displayText("12.");
+  checkStream(bus, left, sizeof(left) / sizeof(left[0]));
+  sevSeg.displayText("12.", true);
+  checkStream(bus, right, sizeof(right) / sizeof(right[0]));
+}
+
+static void testChain(void)
+{
+  MockBus bus;
+  SevSeg_MAX7219 sevSeg(bus, 10, 2);
+  // one frame per digit row, the word for the second chip is shifted first
+  // and chips without a change get a NOOP
+  static const uint16_t expected[] = {
+    0x015b, 0x0130, 0xffff,
+    0x0000, 0x026d, 0xffff,
+    0x0000, 0x0379, 0xffff,
+    0x0000, 0x0433, 0xffff
+  };
+  static const uint16_t control[] = {
+    0x0a05, 0x0a05, 0xffff
+  };
+
+  sevSeg.begin();
+  bus.n = 0;
+  sevSeg.displayText("12345");
+  checkStream(bus, expected, sizeof(expected) / sizeof(expected[0]));
+  sevSeg.brightness(5);
+  checkStream(bus, control, sizeof(control) / sizeof(control[0]));
+}
+
+static void testSoftBus(void)
+{
+  SevSeg_MAX7219 sevSeg(12, 11, 10);
+
+  sevSeg.begin();
+  unsigned long writes = hostPinWrites;
+  sevSeg.displayChar(0, '8', false);
+  // CS low and high, 16 bits with data and two clock edges each
+  CHECK_EQUAL(2 + 16 * 3, hostPinWrites - writes);
+  CHECK_EQUAL(HIGH, hostPinLevel[10]);
+  CHECK_EQUAL(LOW, hostPinLevel[11]);
+  CHECK_EQUAL(1, hostPinLevel[12]);   // last bit of 0x017f
+}
+
+// Every word goes through the SPI peripheral in its own transaction, with
+// CS low only inside it.
+static void checkSPIStream(const uint16_t * expected, int count)
+{
+  static const HostSPIEventType frame[] = {
+    HOST_SPI_BEGIN_TRANSACTION, HOST_PIN_LOW, HOST_SPI_WORD, HOST_PIN_HIGH, HOST_SPI_END_TRANSACTION
+  };
+  unsigned int e = 0;
+
+  // begin() drives CS high before the first frame
+  while (e < SPI.events && e < HOST_SPI_LOG && SPI.log[e].type == HOST_PIN_HIGH) {
+    CHECK_EQUAL(10, SPI.log[e].value);
+    e++;
+  }
+  CHECK_EQUAL(e + 5 * count, SPI.events);
+  for (int i = 0; i < count && e + 5 <= SPI.events; i++) {
+    for (int f = 0; f < 5; f++, e++) {
+      CHECK_EQUAL(frame[f], SPI.log[e].type);
+      if (frame[f] == HOST_PIN_LOW || frame[f] == HOST_PIN_HIGH) CHECK_EQUAL(10, SPI.log[e].value);
+      if (frame[f] == HOST_SPI_WORD) CHECK_EQUAL(expected[i], SPI.log[e].value);
+    }
+  }
+  SPI.clearLog();
+}
+
+// The hardware SPI bus of SevSeg_MAX7219(cs): 10 MHz, mode 0, MSB first.
+static void testSPIBus(void)
+{
+  SevSeg_MAX7219 sevSeg(10);
+  static const uint16_t begin[] = {
+    0x0b03, 0x0900, 0x0100, 0x0200, 0x0300, 0x0400, 0x0f00, 0x0a0f, 0x0c01
+  };
+  static const uint16_t text[] = { 0x0130, 0x02ed };    // "12."
+
+  SPI.clearLog();
+  sevSeg.begin();
+  checkSPIStream(begin, sizeof(begin) / sizeof(begin[0]));
+  CHECK_EQUAL(10000000, SPI.settings.clock);
+  CHECK_EQUAL(MSBFIRST, SPI.settings.bitOrder);
+  CHECK_EQUAL(SPI_MODE0, SPI.settings.dataMode);
+
+  sevSeg.displayText("12.");
+  checkSPIStream(text, sizeof(text) / sizeof(text[0]));
+}
+
+// A copy would free the buffers of the original.
+static_assert(!std::is_copy_constructible<SevSeg_MAX7219>::value, "display copyable");
+static_assert(!std::is_copy_assignable<SevSeg_MAX7219>::value, "display assignable");
+static_assert(!std::is_copy_constructible<SevSeg_MAX7219_T<12, 11, 10> >::value, "display copyable");
+
+// A destroyed display leaves its bus, and a display may outlive its bus.
+static void testLifetime(void)
+{
+  MockBus bus;
+  SevSeg_MAX7219 * first = new SevSeg_MAX7219(bus, 10);
+  SevSeg_MAX7219 second(bus, 10);
+
+  first->begin();
+  second.begin();
+  delete first;
+  bus.n = 0;
+  bus.beginUpdate();
+  second.displayText("1");
+  bus.commit();
+  CHECK_EQUAL(2, bus.n);      // one row of the remaining display
+  CHECK_EQUAL(0, bus.badCs);
+
+  // the bus is overwritten before the display goes
+  static union { long align; char bytes[sizeof(MockBus)]; } storage;
+  MockBus * gone = new (storage.bytes) MockBus;
+  SevSeg_MAX7219 * orphan = new SevSeg_MAX7219(*gone, 10);
+  orphan->begin();
+  gone->~MockBus();
+  memset(storage.bytes, 0xa5, sizeof(storage.bytes));
+  delete orphan;
+
+  // the fixed pin bus is part of the object
+  SevSeg_MAX7219_T<12, 11, 10, 4> * fixed = new SevSeg_MAX7219_T<12, 11, 10, 4>;
+  fixed->begin();
+  fixed->displayText("1234");
+  delete fixed;
+}
+
+int main(void)
+{
+  testBegin();
+  testDisplayText();
+  testChain();
+  testSoftBus();
+  testSPIBus();
+  testLifetime();
+  return TEST_RESULT();
+}
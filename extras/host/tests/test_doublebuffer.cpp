@@ -0,0 +1,160 @@
+/*
+ * Module         : test_doublebuffer.cpp
+ * Description    : swap() with a writer interrupting the transmission
+ *
+ * Built for the host and, with fake_avr.h, for the AVR status register code.
+ */
+
+#include <SevSeg_MAX7219.h>
+#include "check.h"
+
+#if defined(__AVR__)
+FakePort fakePorts[5];
+uint8_t SREG = 0x80;
+
+void FakePort::written(void)
+{
+}
+
+static bool interruptsEnabled(void) { return SREG & 0x80; }
+static void setInterrupts(bool on) { SREG = on ? 0x80 : 0x00; }
+#else
+static bool interruptsEnabled(void) { return hostInterrupts; }
+static void setInterrupts(bool on) { hostInterrupts = on; }
+#endif
+
+// Counts the frames and calls isr once from within the next transfer, like
+// an interrupt arriving while swap() is sending.
+class InterruptedBus : public SevSeg_MAX7219_Bus
+{
+public:
+
+  InterruptedBus() : frames(0), open(false), badCs(0), disabled(0), isr(NULL) { }
+
+  virtual void begin(void) { }
+  virtual void select(byte csPin)
+  {
+    if (open) badCs++;
+    open = true;
+  }
+  virtual void transfer16(uint16_t data)
+  {
+    if (!open) badCs++;
+    if (!interruptsEnabled()) disabled++;
+    if (isr != NULL) {
+      void (*handler)(void) = isr;
+      isr = NULL;
+      handler();
+    }
+  }
+  virtual bool deselect(byte csPin)
+  {
+    if (!open) badCs++;
+    open = false;
+    frames++;
+    return true;
+  }
+
+  int frames;
+  bool open;
+  int badCs;
+  int disabled;       // words sent with interrupts disabled
+  void (*isr)(void);
+
+};
+
+static InterruptedBus bus;
+static SevSeg_MAX7219 sevSeg(bus, 10);
+static SevSeg_MAX7219_Viewport counter(sevSeg, 4, 4);
+
+static void writeCounter(void)
+{
+  counter.displayNumber(42);
+}
+
+static void testInterruptedSwap(void)
+{
+  sevSeg.begin(8);
+  sevSeg.doubleBuffer();
+
+  // writers only fill the back buffer
+  bus.frames = 0;
+  sevSeg.displayText("ABCDEFGH");
+  CHECK_EQUAL(0, bus.frames);
+
+  bus.isr = writeCounter;
+  sevSeg.swap();
+  CHECK(bus.isr == NULL);
+  CHECK_EQUAL(0, bus.badCs);
+  CHECK_EQUAL(8, bus.frames);
+  CHECK_EQUAL(0, bus.disabled);
+
+  // the interrupt's digits follow with the next swap
+  bus.frames = 0;
+  sevSeg.swap();
+  CHECK_EQUAL(0, bus.badCs);
+  CHECK_EQUAL(4, bus.frames);
+}
+
+static InterruptedBus shared;
+static SevSeg_MAX7219 direct(shared, 9);
+
+static void writeDirect(void)
+{
+  direct.displayChar(0, '7', false);
+}
+
+// The same for the pass of a bus commit, without double buffering.
+static void testInterruptedBusCommit(void)
+{
+  direct.begin(8);
+  shared.badCs = 0;
+  shared.beginUpdate();
+  direct.displayText("ABCDEFGH");
+  shared.isr = writeDirect;
+  shared.commit();
+  CHECK(shared.isr == NULL);
+  CHECK_EQUAL(0, shared.badCs);
+
+  // the interrupt's digit follows with the next update
+  shared.frames = 0;
+  direct.displayChar(7, '0', false);
+  CHECK_EQUAL(0, shared.badCs);
+  CHECK_EQUAL(2, shared.frames);
+}
+
+// swap() from an interrupt handler leaves interrupts disabled.
+static void testSwapInInterrupt(void)
+{
+  sevSeg.displayText("12345678");
+  setInterrupts(false);
+  sevSeg.swap();
+#if defined(__AVR__)
+  CHECK(!interruptsEnabled());
+#endif
+  setInterrupts(true);
+  sevSeg.swap();
+  CHECK(interruptsEnabled());
+}
+
+// Inside beginUpdate() the swapped frame is sent by commit().
+static void testDeferredSwap(void)
+{
+  sevSeg.displayText("HELLO   ");
+  bus.frames = 0;
+  sevSeg.beginUpdate();
+  sevSeg.swap();
+  CHECK_EQUAL(0, bus.frames);
+  sevSeg.commit();
+  CHECK_EQUAL(0, bus.badCs);
+  CHECK(bus.frames > 0);
+}
+
+int main(void)
+{
+  testInterruptedSwap();
+  testInterruptedBusCommit();
+  testSwapInInterrupt();
+  testDeferredSwap();
+  return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+/*
+ * Module         : test_fallback.cpp
+ * Description    : All 256 byte values under each SevSeg_MAX7219_Fallback policy
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+static const byte GLYPH = 0B01001001;
+static const byte EIGHT = 0x7f;
+
+static bool inFont(int b)
+{
+  return b >= ' ' && b <= '}';
+}
+
+// Register value expected for character b, or -1 if it is skipped
+static int expected(SevSeg_MAX7219_Fallback policy, int b)
+{
+  if (inFont(b)) return pgm_read_byte(SevSeg_MAX7219_Font + b - ' ');
+  switch (policy) {
+  case SEVSEG_FALLBACK_BLANK: return 0x00;
+  case SEVSEG_FALLBACK_GLYPH: return GLYPH;
+  default:                    return -1;
+  }
+}
+
+static void testPolicy(SevSeg_MAX7219_Fallback policy)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(8);
+  sevSeg.setFallback(policy, GLYPH);
+  for (int b = 0; b < 256; b++) {
+    int e = expected(policy, b);
+
+    // displayChar(): a skipped character leaves the digit alone and sends nothing
+    sevSeg.displayChar(0, '8', false);
+    sim.resetCounters();
+    sevSeg.displayChar(0, (char) b, false);
+    CHECK_EQUAL(e < 0 ? EIGHT : e, sim.chip(0).digit[0]);
+    CHECK_EQUAL(e < 0 ? 0 : 1, sim.frames);
+
+    // write(): a skipped character does not move the cursor
+    if (b != '.') {
+      sevSeg.clear();
+      sevSeg.write((uint8_t) b);
+      sevSeg.write('8');
+      if (e < 0) {
+        CHECK_EQUAL(EIGHT, sim.chip(0).digit[0]);
+      } else {
+        CHECK_EQUAL(e, sim.chip(0).digit[0]);
+        CHECK_EQUAL(EIGHT, sim.chip(0).digit[1]);
+      }
+    }
+
+    // displayText(): a skipped character takes no digit
+    if (b != '\0' && b != '.') {
+      char text[3] = { (char) b, '8', '\0' };
+      sevSeg.clear();
+      sevSeg.displayText(text, true);
+      if (e < 0) {
+        CHECK_EQUAL(EIGHT, sim.chip(0).digit[7]);
+        CHECK_EQUAL(0x00, sim.chip(0).digit[6]);
+      } else {
+        CHECK_EQUAL(e, sim.chip(0).digit[6]);
+        CHECK_EQUAL(EIGHT, sim.chip(0).digit[7]);
+      }
+    }
+  }
+}
+
+int main(void)
+{
+  testPolicy(SEVSEG_FALLBACK_BLANK);
+  testPolicy(SEVSEG_FALLBACK_GLYPH);
+  testPolicy(SEVSEG_FALLBACK_SKIP);
+  return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+/*
+ * Module         : test_font.cpp
+ * Description    : The fonts against the table of the original library
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+// The original table: segments a b c d e f g dp from the MSB, rotated to
+// register order by lookup().
+static const byte pattern[94] = {
+  0B00000000, 0B01100001, 0B01000100, 0B01101110, 0,           // space!"#$
+  0,          0,          0B01000000, 0B10011100, 0B11110000,  // %&'()
+  0,          0,          0,          0B00000010, 0B00000001,  // *+,-.
+  0,                                                           // /
+  0xfc, 0x60, 0xda, 0xf2, 0x66,  // 0-4
+  0xb6, 0xbe, 0xe0, 0xfe, 0xf6,  // 5-9
+  0,          0,          0,          0B00010010, 0,           // :;<=>
+  0B11001011, 0B11111010,                                      // ?@
+  0B11101110, 0B11111110, 0B10011100, 0B01111010, 0B10011110,  // A-E
+  0B10001110, 0B10111100, 0B01101110, 0B01100000, 0B01110000,  // F-J
+  0B10101110, 0B00011100, 0B10101000, 0B11101100, 0B11111100,  // K-O
+  0B11001110, 0B11100110, 0B00001010, 0B10110110, 0B00011110,  // P-T
+  0B01111100, 0,          0,          0,          0B01110110,  // U-Y
+  0B11011010,                                                  // Z
+  0B10011100, 0B00000100, 0B11110000, 0,          0B00010000,  // [\]^_
+  0B01000000,                                                  // '
+  0B11111010, 0B00111110, 0B00011010, 0B01111010, 0B11011110,  // a-e
+  0B10001110, 0B11110110, 0B00101110, 0B00001000, 0B00110000,  // f-j
+  0B10101110, 0B00001100, 0B10101000, 0B00101010, 0B00111010,  // k-o
+  0B11001110, 0B11100110, 0B00001010, 0B10110110, 0B00011110,  // p-t
+  0B00111000, 0,          0,          0,          0B01110110,  // u-y
+  0B11011010,                                                  // z
+  0B10011100, 0B00001100, 0B11110000                           // {|}
+};
+
+static byte rotated(char c)
+{
+  byte pat = pattern[c - ' '];
+  return (byte) ((pat >> 1) | (pat << 7));
+}
+
+static void testTable(void)
+{
+  for (char c = ' '; c <= '}'; c++)
+    CHECK_EQUAL(rotated(c), pgm_read_byte(SevSeg_MAX7219_Font + c - ' '));
+}
+
+// The extended font only adds patterns where the original one had none.
+static void testExtended(void)
+{
+  for (char c = ' '; c <= '}'; c++) {
+    if (rotated(c) != 0)
+      CHECK_EQUAL(rotated(c), pgm_read_byte(SevSeg_MAX7219_FontExtended + c - ' '));
+  }
+  CHECK_EQUAL(0B01100011, pgm_read_byte(SevSeg_MAX7219_FontExtended + 0xb0 - ' '));
+}
+
+// What the chip receives, with and without dp. ! . ? include the dp in the font.
+static void testDisplay(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(8);
+  for (char c = ' '; c <= '}'; c++) {
+    sevSeg.displayChar(0, c, false);
+    CHECK_EQUAL(rotated(c), sim.chip(0).digit[0]);
+    sevSeg.displayChar(1, c, true);
+    CHECK_EQUAL(rotated(c) | 0x80, sim.chip(0).digit[1]);
+  }
+}
+
+int main(void)
+{
+  testTable();
+  testExtended();
+  testDisplay();
+  return TEST_RESULT();
+}
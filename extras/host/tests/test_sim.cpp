@@ -0,0 +1,90 @@
+/*
+ * Module         : test_sim.cpp
+ * Description    : The simulated chain against the datasheet's shift register behaviour
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+static void testPowerUp(void)
+{
+  SevSeg_MAX7219_SimBus sim(2);
+
+  for (byte n = 0; n < 2; n++) {
+    CHECK_EQUAL(0, sim.chip(n).shutdown);
+    CHECK_EQUAL(0, sim.chip(n).intensity);
+    CHECK_EQUAL(0, sim.chip(n).scanLimit);
+  }
+}
+
+static void testChain(void)
+{
+  SevSeg_MAX7219_SimBus sim(2);
+
+  // the first word ends up in the last chip
+  sim.select(10);
+  sim.transfer16(0x0105);
+  sim.transfer16(0x0a07);
+  sim.deselect(10);
+  CHECK_EQUAL(0x05, sim.chip(1).digit[0]);
+  CHECK_EQUAL(0x07, sim.chip(0).intensity);
+  CHECK_EQUAL(0x00, sim.chip(0).digit[0]);
+  CHECK_EQUAL(1, sim.frames);
+  CHECK_EQUAL(2, sim.words);
+
+  // NOOP leaves a chip alone
+  sim.select(10);
+  sim.transfer16(0x0000);
+  sim.transfer16(0x0101);
+  sim.deselect(10);
+  CHECK_EQUAL(0x05, sim.chip(1).digit[0]);
+  CHECK_EQUAL(0x01, sim.chip(0).digit[0]);
+}
+
+static void testBegin(void)
+{
+  SevSeg_MAX7219_SimBus sim(2);
+  SevSeg_MAX7219 sevSeg(sim, 10, 2);
+
+  sevSeg.begin(8);
+  for (byte n = 0; n < 2; n++) {
+    CHECK_EQUAL(1, sim.chip(n).shutdown);
+    CHECK_EQUAL(0, sim.chip(n).test);
+    CHECK_EQUAL(15, sim.chip(n).intensity);
+    CHECK_EQUAL(7, sim.chip(n).scanLimit);
+    CHECK_EQUAL(0, sim.chip(n).decode);
+  }
+
+  sevSeg.print("HELLO 12.3");
+  CHECK_EQUAL(0B00110111, sim.segments(0, 0));  // H
+  CHECK_EQUAL(0B01001111, sim.segments(0, 1));  // E
+  CHECK_EQUAL(0x30, sim.segments(0, 6));         // 1
+  CHECK_EQUAL(0x80 | 0x6d, sim.segments(0, 7));  // 2.
+  CHECK_EQUAL(0x79, sim.segments(1, 0));         // 3 on the second chip
+}
+
+static void testDecode(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+
+  sim.select(10);
+  sim.transfer16(0x0901);   // Code B for digit 0
+  sim.deselect(10);
+  sim.select(10);
+  sim.transfer16(0x018a);   // '-' with dp
+  sim.deselect(10);
+  CHECK_EQUAL(0x81, sim.segments(0, 0));
+
+  sim.reset();
+  CHECK_EQUAL(0, sim.chip(0).decode);
+}
+
+int main(void)
+{
+  testPowerUp();
+  testChain();
+  testBegin();
+  testDecode();
+  return TEST_RESULT();
+}
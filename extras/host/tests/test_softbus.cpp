@@ -0,0 +1,93 @@
+/*
+ * Module         : test_softbus.cpp
+ * Description    : Bit sequence of the AVR port register code of SevSeg_MAX7219_SoftBus
+ */
+
+#include <SevSeg_MAX7219_Bus.h>
+#include "check.h"
+
+FakePort fakePorts[5];
+uint8_t SREG = 0x80;
+
+// PORTB and PORTD after every write, and whether interrupts were enabled
+struct Sample {
+  uint8_t portB, portD;
+  bool interrupts;
+};
+
+static Sample samples[256];
+static int count;
+
+void FakePort::written(void)
+{
+  if (count < 256) {
+    Sample & s = samples[count++];
+    s.portB = fakePorts[FAKE_PORTB].value;
+    s.portD = fakePorts[FAKE_PORTD].value;
+    s.interrupts = SREG & 0x80;
+  }
+}
+
+// DIN 11 (PB3), CLK 13 (PB5), CS 0 (PD0). The other port bits are set and
+// must stay set.
+static void testTransfer(void)
+{
+  SevSeg_MAX7219_SoftBus bus(11, 13);
+
+  fakePorts[FAKE_PORTB].value = 0x41;
+  fakePorts[FAKE_PORTD].value = 0x81;
+  bus.begin();
+  count = 0;
+  bus.select(0);
+  bus.transfer16(0xa5c3);
+  bus.transfer16(0x0f01);
+  bus.deselect(0);
+
+  uint32_t bits = 0;
+  int n = 0;
+  bool cs = true, clk = false;
+  int frames = 0;
+  for (int i = 0; i < count; i++) {
+    const Sample & s = samples[i];
+    bool newCs = s.portD & 0x01;
+    bool newClk = s.portB & 0x20;
+    if (cs && !newCs) frames++;
+    if (!clk && newClk) {
+      CHECK(!newCs);
+      bits = (bits << 1) | ((s.portB & 0x08) ? 1 : 0);
+      n++;
+    }
+    cs = newCs;
+    clk = newClk;
+    CHECK(!s.interrupts);
+    CHECK_EQUAL(0x41, s.portB & ~0x28);
+    CHECK_EQUAL(0x80, s.portD & ~0x01);
+  }
+  CHECK_EQUAL(1, frames);
+  CHECK_EQUAL(32, n);
+  CHECK_EQUAL(0xa5c30f01UL, bits);
+  CHECK(cs);
+  CHECK(!clk);
+  CHECK_EQUAL(0x80, SREG);
+}
+
+// Interrupts disabled by the caller stay disabled.
+static void testInterruptsOff(void)
+{
+  SevSeg_MAX7219_SoftBus bus(11, 13);
+
+  bus.begin();
+  SREG = 0x00;
+  bus.select(5);
+  bus.transfer16(0x0100);
+  bus.deselect(5);
+  CHECK_EQUAL(0x00, SREG);
+  SREG = 0x80;
+}
+
+int main(void)
+{
+  testTransfer();
+  testInterruptsOff();
+  return TEST_RESULT();
+}
@@ -0,0 +1,95 @@
+/*
+ * Module         : test_text.cpp
+ * Description    : Dots and lengths in displayText()
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+static const byte digitSegments[] = {
+  0x7e, 0x30, 0x6d, 0x79, 0x33, 0x5b, 0x5f, 0x70, 0x7f, 0x7b
+};
+
+// expected: one character per digit of chip 0, '_' blank, '.' blank with dp,
+// a digit followed by '.' has its dp lit
+static void checkText(SevSeg_MAX7219_SimBus & sim, const char * expected)
+{
+  for (byte d = 0; d < 8 && *expected; d++) {
+    byte seg = 0x00;
+    bool digit = *expected >= '0' && *expected <= '9';
+    if (digit) seg = digitSegments[*expected - '0'];
+    if (*expected == '.') seg = 0x80;
+    expected++;
+    if (digit && *expected == '.') {
+      seg |= 0x80;
+      expected++;
+    }
+    CHECK_EQUAL(seg, sim.segments(0, d));
+  }
+}
+
+static void testDots(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(8);
+  // a dot without a character before it gets a blank digit
+  sevSeg.displayText(".5");
+  checkText(sim, "." "5" "______");
+  sevSeg.clear();
+  sevSeg.displayText("...");
+  checkText(sim, "." "________");
+  sevSeg.clear();
+
+  // a run of dots lights one dp
+  sevSeg.displayText("1..2...3");
+  checkText(sim, "1." "2." "3" "_____");
+  sevSeg.clear();
+
+  sevSeg.displayText(".5", true);
+  checkText(sim, "______" "." "5");
+  sevSeg.clear();
+  sevSeg.displayText("1.2.", true);
+  checkText(sim, "______" "1." "2.");
+}
+
+// Text longer than the display is cut, from either side the same way.
+static void testLength(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(8);
+  sevSeg.displayText("1234567890123456789012");
+  checkText(sim, "12345678");
+  sevSeg.clear();
+  sevSeg.displayText("1234567890123456789012", true);
+  checkText(sim, "12345678");
+  sevSeg.clear();
+  sevSeg.displayText("12", true);
+  checkText(sim, "______12");
+}
+
+// 22 characters fill 22 digits of three chips, no 16 character limit.
+static void testChain(void)
+{
+  SevSeg_MAX7219_SimBus sim(3);
+  SevSeg_MAX7219 sevSeg(sim, 10, 3);
+
+  sevSeg.begin(8);
+  sevSeg.displayText("1234567890123456789012.", true);
+  CHECK_EQUAL(0x00, sim.segments(0, 0));
+  CHECK_EQUAL(0x00, sim.segments(0, 1));
+  for (byte d = 2; d < 24; d++)
+    CHECK_EQUAL(digitSegments[(d - 1) % 10] | (d == 23 ? 0x80 : 0x00), sim.segments(d / 8, d % 8));
+}
+
+int main(void)
+{
+  testDots();
+  testLength();
+  testChain();
+  return TEST_RESULT();
+}
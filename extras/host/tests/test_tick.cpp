@@ -0,0 +1,263 @@
+/*
+ * Module         : test_tick.cpp
+ * Description    : Animations, dimming and register refresh driven by tick()
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+static void checkDigits(SevSeg_MAX7219_SimBus & sim, byte d0, byte d1, byte d2, byte d3)
+{
+  CHECK_EQUAL(d0, sim.segments(0, 0));
+  CHECK_EQUAL(d1, sim.segments(0, 1));
+  CHECK_EQUAL(d2, sim.segments(0, 2));
+  CHECK_EQUAL(d3, sim.segments(0, 3));
+}
+
+// "12" enters on the right, one digit per interval.
+static void testMarquee(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(4);
+  hostMillis = 1000;
+  sevSeg.scrollText("12", 100);
+  checkDigits(sim, 0x00, 0x00, 0x00, 0x00);
+  hostMillis = 1099;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x00, 0x00);
+  hostMillis = 1100;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x00, 0x30);
+  hostMillis = 1200;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x30, 0x6d);
+
+  // after the text and the blanks it starts over
+  for (int i = 0; i < 4; i++) {
+    hostMillis += 100;
+    sevSeg.tick();
+  }
+  checkDigits(sim, 0x00, 0x00, 0x00, 0x00);
+
+  sevSeg.noScrollText();
+  hostMillis += 100;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x00, 0x00);
+}
+
+static void testBlink(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(4);
+  sevSeg.displayText("1234");
+  hostMillis = 2000;
+  sevSeg.blink(0x03, 100);
+  hostMillis = 2100;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x79, 0x33);
+  hostMillis = 2200;
+  sevSeg.tick();
+  checkDigits(sim, 0x30, 0x6d, 0x79, 0x33);
+
+  // stopping in the dark phase restores the digits
+  hostMillis = 2300;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x79, 0x33);
+  sevSeg.noBlink();
+  checkDigits(sim, 0x30, 0x6d, 0x79, 0x33);
+  hostMillis = 2400;
+  sevSeg.tick();
+  checkDigits(sim, 0x30, 0x6d, 0x79, 0x33);
+
+  // and so does switching to other digits
+  sevSeg.blink(0x03, 100);
+  hostMillis = 2500;
+  sevSeg.tick();
+  checkDigits(sim, 0x00, 0x00, 0x79, 0x33);
+  sevSeg.blink(0x0c, 100);
+  checkDigits(sim, 0x30, 0x6d, 0x79, 0x33);
+  hostMillis = 2600;
+  sevSeg.tick();
+  checkDigits(sim, 0x30, 0x6d, 0x00, 0x00);
+}
+
+// from full brightness (fine level 0xf0) down to 0 in 1 s
+static void testFade(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(4);
+  hostMillis = 3000;
+  sevSeg.fadeBrightness(0, 1000);
+  sevSeg.tick();
+  CHECK_EQUAL(15, sim.chip(0).intensity);
+  hostMillis = 3250;
+  sevSeg.tick();
+  CHECK_EQUAL(11, sim.chip(0).intensity);   // 0xb4
+  hostMillis = 3500;
+  sevSeg.tick();
+  CHECK_EQUAL(7, sim.chip(0).intensity);    // 0x78
+  hostMillis = 4000;
+  sevSeg.tick();
+  CHECK_EQUAL(0, sim.chip(0).intensity);
+  hostMillis = 4500;
+  sevSeg.tick();
+  CHECK_EQUAL(0, sim.chip(0).intensity);
+}
+
+// Fine level 0x28 is chip level 2 and a half: every second tick shows 3.
+static void testDither(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+  int high = 0;
+
+  sevSeg.begin(4);
+  sevSeg.fineBrightness(0x28);
+  CHECK_EQUAL(2, sim.chip(0).intensity);
+  sevSeg.dither();
+  for (int i = 0; i < 16; i++) {
+    sevSeg.tick();
+    CHECK(sim.chip(0).intensity == 2 || sim.chip(0).intensity == 3);
+    if (sim.chip(0).intensity == 3) high++;
+  }
+  CHECK_EQUAL(8, high);
+
+  // 3/16 of the ticks
+  high = 0;
+  sevSeg.fineBrightness(0x23);
+  for (int i = 0; i < 16; i++) {
+    sevSeg.tick();
+    if (sim.chip(0).intensity == 3) high++;
+  }
+  CHECK_EQUAL(3, high);
+
+  // nothing above the top level
+  sevSeg.fineBrightness(0xff);
+  for (int i = 0; i < 16; i++) {
+    sevSeg.tick();
+    CHECK_EQUAL(15, sim.chip(0).intensity);
+  }
+
+  sevSeg.fineBrightness(0x28);
+  sevSeg.noDither();
+  for (int i = 0; i < 4; i++) {
+    sevSeg.tick();
+    CHECK_EQUAL(2, sim.chip(0).intensity);
+  }
+}
+
+// A fade in fine levels, 0x00 to 0x20 in 1 s, crosses chip levels 0, 1, 2.
+static void testFineFade(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+
+  sevSeg.begin(4);
+  sevSeg.fineBrightness(0x00);
+  hostMillis = 5000;
+  sevSeg.fadeFineBrightness(0x20, 1000);
+  hostMillis = 5250;
+  sevSeg.tick();
+  CHECK_EQUAL(0, sim.chip(0).intensity);    // 0x08
+  hostMillis = 5500;
+  sevSeg.tick();
+  CHECK_EQUAL(1, sim.chip(0).intensity);    // 0x10
+  hostMillis = 5999;
+  sevSeg.tick();
+  CHECK_EQUAL(1, sim.chip(0).intensity);    // 0x1f
+  hostMillis = 6000;
+  sevSeg.tick();
+  CHECK_EQUAL(2, sim.chip(0).intensity);
+
+  // downwards with dithering: 0x20 to 0x10 passes 0x18, level 1 and a half
+  sevSeg.dither();
+  sevSeg.fadeFineBrightness(0x10, 1000);
+  hostMillis = 6500;
+  int high = 0;
+  for (int i = 0; i < 16; i++) {
+    sevSeg.tick();
+    if (sim.chip(0).intensity == 2) high++;
+  }
+  CHECK_EQUAL(8, high);
+}
+
+static void checkChips(SevSeg_MAX7219_SimBus & expected, SevSeg_MAX7219_SimBus & actual)
+{
+  for (byte n = 0; n < expected.devices(); n++) {
+    const SevSeg_MAX7219_SimChip & e = expected.chip(n);
+    const SevSeg_MAX7219_SimChip & a = actual.chip(n);
+    CHECK_EQUAL(e.decode, a.decode);
+    CHECK_EQUAL(e.intensity, a.intensity);
+    CHECK_EQUAL(e.scanLimit, a.scanLimit);
+    CHECK_EQUAL(e.shutdown, a.shutdown);
+    CHECK_EQUAL(e.test, a.test);
+    for (byte d = 0; d < 8; d++)
+      CHECK_EQUAL(e.digit[d], a.digit[d]);
+  }
+}
+
+// 8 digit rows and 5 control registers: with a period of 1.3 s one register
+// every 100 ms. A reset chain is restored after 13 steps.
+static void testRefresh(void)
+{
+  SevSeg_MAX7219_SimBus ref(2);
+  SevSeg_MAX7219 refSeg(ref, 10, 2);
+  SevSeg_MAX7219_SimBus sim(2);
+  SevSeg_MAX7219 sevSeg(sim, 10, 2);
+
+  refSeg.begin(8);
+  refSeg.displayText("0123456789AbCdEF");
+  refSeg.brightness(5);
+  sevSeg.begin(8);
+  sevSeg.displayText("0123456789AbCdEF");
+  sevSeg.brightness(5);
+
+  hostMillis = 10000;
+  sevSeg.refresh(1300);
+  sim.reset();
+  sim.resetCounters();
+  hostMillis = 10099;
+  sevSeg.tick();
+  CHECK_EQUAL(0, sim.frames);
+
+  for (int step = 1; step <= 13; step++) {
+    hostMillis = 10000 + step * 100;
+    sevSeg.tick();
+    CHECK_EQUAL(step, sim.frames);
+    // the shutdown register comes last
+    CHECK_EQUAL(step == 13 ? 1 : 0, sim.chip(1).shutdown);
+  }
+  checkChips(ref, sim);
+
+  // and starts over
+  sim.reset();
+  for (int step = 14; step <= 26; step++) {
+    hostMillis = 10000 + step * 100;
+    sevSeg.tick();
+  }
+  checkChips(ref, sim);
+
+  sevSeg.noRefresh();
+  sim.resetCounters();
+  hostMillis += 1000;
+  sevSeg.tick();
+  CHECK_EQUAL(0, sim.frames);
+}
+
+int main(void)
+{
+  testMarquee();
+  testBlink();
+  testFade();
+  testDither();
+  testFineFade();
+  testRefresh();
+  return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+/*
+ * Module         : test_viewport.cpp
+ * Description    : Fields of digits sharing one display
+ */
+
+#include <SevSeg_MAX7219.h>
+#include <SevSeg_MAX7219_Sim.h>
+#include "check.h"
+
+static void testFields(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+  SevSeg_MAX7219_Viewport value(sevSeg, 0, 5);
+  SevSeg_MAX7219_Viewport unit(sevSeg, 5, 3);
+
+  sevSeg.begin(8);
+  value.displayFixed(-123, 1);
+  unit.displayText("Hz", true);
+  CHECK_EQUAL(0x00, sim.segments(0, 0));
+  CHECK_EQUAL(0x01, sim.segments(0, 1));         // -
+  CHECK_EQUAL(0x30, sim.segments(0, 2));         // 1
+  CHECK_EQUAL(0x80 | 0x6d, sim.segments(0, 3));  // 2.
+  CHECK_EQUAL(0x79, sim.segments(0, 4));         // 3
+  CHECK_EQUAL(0x00, sim.segments(0, 5));
+  CHECK_EQUAL(0x37, sim.segments(0, 6));         // H
+
+  // only the digits of the field are sent
+  sim.resetCounters();
+  value.displayFixed(-124, 1);
+  CHECK_EQUAL(1, sim.frames);
+
+  // numbers which do not fit the field show dashes there
+  value.displayNumber(123456);
+  for (byte d = 0; d < 5; d++)
+    CHECK_EQUAL(0x01, sim.segments(0, d));
+  CHECK_EQUAL(0x37, sim.segments(0, 6));
+}
+
+static void testPrint(void)
+{
+  SevSeg_MAX7219_SimBus sim(1);
+  SevSeg_MAX7219 sevSeg(sim, 10);
+  SevSeg_MAX7219_Viewport field(sevSeg, 2, 3);
+
+  sevSeg.begin(8);
+  sevSeg.print("88888888");
+  field.clear();
+  field.print("1.2345");
+  CHECK_EQUAL(0x7f, sim.segments(0, 1));
+  CHECK_EQUAL(0x80 | 0x30, sim.segments(0, 2));  // 1.
+  CHECK_EQUAL(0x6d, sim.segments(0, 3));
+  CHECK_EQUAL(0x79, sim.segments(0, 4));
+  CHECK_EQUAL(0x7f, sim.segments(0, 5));
+
+  field.clear();
+  field.autoScroll();
+  field.print("12345");
+  CHECK_EQUAL(0x79, sim.segments(0, 2));
+  CHECK_EQUAL(0x33, sim.segments(0, 3));
+  CHECK_EQUAL(0x5b, sim.segments(0, 4));
+  CHECK_EQUAL(0x7f, sim.segments(0, 5));
+}
+
+// Numbers in one field must not switch another field's rows to Code B.
+static void testAutoDecode(void)
+{
+  SevSeg_MAX7219_SimBus sim(2);
+  SevSeg_MAX7219 sevSeg(sim, 10, 2);
+  SevSeg_MAX7219_Viewport value(sevSeg, 0, 4);
+  SevSeg_MAX7219_Viewport unit(sevSeg, 4, 4);
+  SevSeg_MAX7219_Viewport second(sevSeg, 8, 8);
+
+  sevSeg.begin(8);
+  sevSeg.autoDecode();
+  unit.displayText("run");
+  second.displayText("Hi");
+  value.displayNumber(123);
+  CHECK_EQUAL(0x05, sim.segments(0, 4));   // r
+  CHECK_EQUAL(0x1c, sim.segments(0, 5));   // u
+  CHECK_EQUAL(0x15, sim.segments(0, 6));   // n
+  CHECK_EQUAL(0x30, sim.segments(0, 1));
+  CHECK_EQUAL(0x79, sim.segments(0, 3));
+  // the rows of value are shared with the second chip
+  CHECK_EQUAL(0x00, sim.chip(0).decode);
+  CHECK_EQUAL(0x37, sim.segments(1, 0));   // H
+
+  // a field covering a row on all chips does use Code B
+  SevSeg_MAX7219_SimBus one(1);
+  SevSeg_MAX7219 single(one, 10, 1);
+  SevSeg_MAX7219_Viewport left(single, 0, 4);
+  SevSeg_MAX7219_Viewport right(single, 4, 4);
+  single.begin(8);
+  single.autoDecode();
+  right.displayText("run");
+  left.displayNumber(42);
+  CHECK_EQUAL(0x0f, one.chip(0).decode);
+  CHECK_EQUAL(0x05, one.segments(0, 4));
+  CHECK_EQUAL(0x6d, one.segments(0, 3));
+}
+
+int main(void)
+{
+  testFields();
+  testPrint();
+  testAutoDecode();
+  return TEST_RESULT();
+}